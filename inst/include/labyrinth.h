@@ -13,8 +13,16 @@
 #include <cstdint>
 #include <numeric>
 #include <algorithm>
+#include <deque>
 #include <omp.h>
 #include <execution>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 // headers in this file are loaded in RcppExports.cpp
 // #include "RcppSparse.h"
@@ -30,7 +38,6 @@
 // [[Rcpp::depends(RcppEigen)]]
 // [[Rcpp::plugins(openmp)]]
 // [[Rcpp::depends(RcppProgress)]]
-// [[Rcpp::depends(diffusr)]]
 
 // other headers are loaded when C++ functions in src/ are being compiled.
 // using namespace RcppSparse;
@@ -47,11 +54,480 @@ using Eigen::SparseMatrix;
 typedef Eigen::Map<SparseMatrix<double>> MSpMat;
 typedef Eigen::Map<MatrixXd> MMatrixXd;
 typedef Eigen::SparseMatrix<double> SpMat;
+typedef Eigen::Map<SparseMatrix<double, RowMajor>> MSpMatR;
+typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowArrayXXd;
+
+// Neighbor lists of a graph, regarding the graph as undirected. Node `u` keeps
+// the sorted ids of its neighbors in inner[outer[u]:outer[u + 1]], and the
+// direction of each edge in `direction`:
+//   - NEIGHBOR_FORWARD: adj_matrix(u, v) != 0, v is a downstream neighbor;
+//   - NEIGHBOR_BACKWARD: adj_matrix(v, u) != 0, v is an upstream neighbor.
+// Self-edges are dropped. Walking a node costs O(deg) instead of O(n).
+enum : unsigned char {
+    NEIGHBOR_FORWARD = 1,
+    NEIGHBOR_BACKWARD = 2,
+    NEIGHBOR_BOTH = NEIGHBOR_FORWARD | NEIGHBOR_BACKWARD
+};
+
+// The direction of an edge seen from the other end
+inline unsigned char reverse_direction(const unsigned char &direction) {
+    return(((direction & NEIGHBOR_FORWARD) << 1) | ((direction & NEIGHBOR_BACKWARD) >> 1));
+}
+
+struct NeighborList {
+    size_t n = 0;
+    vector<size_t> outer;
+    vector<int> inner;
+    vector<unsigned char> direction;
+    // The original id of each node when the nodes were reordered by
+    // permute_neighbors(), empty otherwise
+    vector<int> node_id;
+
+    inline size_t degree(const size_t &node) const {
+        return outer[node + 1] - outer[node];
+    }
+    inline size_t edges() const {
+        return inner.size();
+    }
+    inline size_t max_degree() const {
+        size_t degree = 0;
+        for (size_t node = 0; node < n; node++) {
+            degree = std::max(degree, this->degree(node));
+        }
+        return degree;
+    }
+    inline size_t original_id(const size_t &node) const {
+        return node_id.empty() ? node : size_t(node_id[node]);
+    }
+    inline size_t bytes() const {
+        return sizeof(size_t) * outer.size() + sizeof(int) * (inner.size() + node_id.size()) + direction.size();
+    }
+};
+
+// A task of an edge-balanced partition of a CSR structure (the neighbor
+// lists, or the rows of a row-major sparse matrix): the nodes
+// [first_node, last_node) with their edges [first_edge, last_edge). Every task
+// holds about EDGE_TASK_GRAIN edges, so that a few hubs of a heavy-tailed graph
+// do not keep one thread busy while the others idle. A hub with more edges is
+// split into several tasks of a single node, marked `split`, whose partial
+// results are reduced afterwards in task order.
+struct EdgeTask {
+    size_t first_node, last_node, first_edge, last_edge;
+    bool split;
+};
+
+// The grain does not depend on the number of threads, nor do the tasks, so
+// reductions over them give the same result with any schedule.
+const size_t EDGE_TASK_GRAIN = 4096;
+
+// The tasks of the nodes [first, last). A node gets the same tasks in any
+// range, so a range only regroups the tasks of whole nodes
+template <typename I>
+vector<EdgeTask> partition_edge_range(const I *outer, const size_t &first, const size_t &last, const size_t &grain = EDGE_TASK_GRAIN) {
+    vector<EdgeTask> tasks;
+    size_t node = first;
+    while (node < last) {
+        size_t degree = outer[node + 1] - outer[node];
+        if (degree > grain) {
+            size_t pieces = (degree + grain - 1) / grain, first_edge = outer[node];
+            for (size_t piece = 0; piece < pieces; piece++) {
+                tasks.push_back({node, node + 1, first_edge + degree * piece / pieces, first_edge + degree * (piece + 1) / pieces, true});
+            }
+            node++;
+            continue;
+        }
+        // Every node costs one more than its degree, so that runs of isolated
+        // nodes are chunked as well. Hubs always start a task of their own
+        size_t first_node = node, cost = 0;
+        while (node < last && cost < grain && size_t(outer[node + 1] - outer[node]) <= grain) {
+            cost += outer[node + 1] - outer[node] + 1;
+            node++;
+        }
+        tasks.push_back({first_node, node, size_t(outer[first_node]), size_t(outer[node]), false});
+    }
+    return(tasks);
+}
+
+template <typename I>
+vector<EdgeTask> partition_edges(const I *outer, const size_t &n, const size_t &grain = EDGE_TASK_GRAIN) {
+    return(partition_edge_range(outer, 0, n, grain));
+}
+
+inline vector<EdgeTask> partition_edges(const NeighborList &neighbors, const size_t &grain = EDGE_TASK_GRAIN) {
+    return(partition_edges(neighbors.outer.data(), neighbors.n, grain));
+}
+
+// The tasks of a parallel loop, taken one at a time in order, as
+// schedule(dynamic, 1) does
+class TaskQueue {
+public:
+    explicit TaskQueue(const size_t &count) : count(count) {}
+
+    bool take(size_t &task) {
+        task = taken++;
+        return(task < count);
+    }
+
+private:
+    const size_t count;
+    std::atomic<size_t> taken{0};
+};
+
+// Run region() on every thread of a parallel loop: the OpenMP team of the
+// kernel, or `workers` threads of their own in the processes forked from the
+// session (see partition.cpp), which cannot use its OpenMP runtime. The
+// threads take the tasks of the loop from a TaskQueue
+template <typename Region>
+inline void parallel_region(const int &workers, Region region) {
+    if (workers > 0) {
+        vector<std::thread> threads;
+        for (int worker = 1; worker < workers; worker++) {
+            threads.emplace_back(region);
+        }
+        region();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        return;
+    }
+    #pragma omp parallel
+    region();
+}
+
+NeighborList build_neighbors(const MSpMat &adj_matrix);
+NeighborList build_neighbors(const MMatrixXd &adj_matrix);
+
+// Reordering of the nodes for cache locality, see graph_order.cpp. order[i]
+// is the original id of the node placed at position i
+vector<int> graph_order(const NeighborList &neighbors, const std::string &method, const bool fix_first);
+NeighborList permute_neighbors(const NeighborList &neighbors, const vector<int> &order);
+MatrixXd permute_rows(const MatrixXd &x, const vector<int> &order);
+MatrixXd restore_rows(const MatrixXd &x, const vector<int> &order);
+
+// The matrix `index` (0 for the graph, 1 for the transition matrix, 2 for its
+// transpose) of a graph store opened by open_graph_store_(), mapped without
+// copying, see graph_store.cpp. The map stays valid while the store is
+// referenced from R
+MSpMat graph_store_matrix(SEXP store, const int &index);
+
+// The rows of a transition matrix W, given the column-compressed t(W): its
+// columns are the rows of W, so the same arrays are read as W in CSR
+inline MSpMatR transition_rows(const MSpMat &transposed) {
+    return(MSpMatR(transposed.cols(), transposed.rows(), transposed.nonZeros(),
+                   const_cast<int *>(transposed.outerIndexPtr()),
+                   const_cast<int *>(transposed.innerIndexPtr()),
+                   const_cast<double *>(transposed.valuePtr())));
+}
+
+// Call callback(v, weight) for every nonzero W(v, u) in the column u of a
+// transition matrix, i.e. the out-edges of u
+template <typename Callback>
+inline void for_each_out_edge(const MSpMat &W, const Index &u, Callback callback) {
+    for (MSpMat::InnerIterator it(W, u); it; ++it) {
+        callback(it.index(), it.value());
+    }
+}
+
+template <typename Callback>
+inline void for_each_out_edge(const MMatrixXd &W, const Index &u, Callback callback) {
+    for (Index v = 0; v < W.rows(); v++) {
+        if (W(v, u) != 0.0) {
+            callback(v, W(v, u));
+        }
+    }
+}
+
+// An optional matrix argument, empty when NULL
+inline MatrixXd optional_matrix(const Nullable<NumericMatrix> &x) {
+    return(x.isNotNull() ? as<MatrixXd>(x.get()) : MatrixXd());
+}
+
+// Seconds of a monotonic clock, which does not need OpenMP
+inline double wall_seconds() {
+    return(std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+enum : int {
+    BIND_NONE,
+    BIND_CORES,
+    BIND_NUMA
+};
+
+// The thread budget of one kernel call, see threads.cpp. Every kernel opens
+// one before its first parallel region. It sets the OpenMP threads of the
+// calling thread (a setting of that thread only, unlike a global default),
+// allows no nested teams, gives MKL the same budget and optionally pins the
+// threads of the team, and restores all of them when it goes out of scope,
+// so a call leaves no trace on later calls. `threads` is clamped to the
+// threads available to the caller, and 0 takes the default of
+// thread_options_().
+class ThreadScope {
+public:
+    explicit ThreadScope(const int &threads = 0);
+    ~ThreadScope();
+    ThreadScope(const ThreadScope &) = delete;
+    ThreadScope &operator=(const ThreadScope &) = delete;
+
+    int threads() const {
+        return(budget);
+    }
+    // The threads the caller had, which the budget cannot exceed
+    int available() const {
+        return(saved_threads);
+    }
+
+private:
+    int budget = 1, saved_threads = 1, saved_levels = 1, saved_mkl = 0;
+    bool bound = false;
+    vector<vector<int>> saved_affinity;
+
+    void bind(const int &binding);
+    void unbind();
+};
+
+// Optional instrumentation of a kernel call, see profile.cpp. It records the
+// wall time of the phases of the call, counters such as the iterations, the
+// edges visited and the bytes of the large buffers allocated, and the busy
+// time of every thread in the parallel loops. A disabled profile records
+// nothing, so the kernels call it unconditionally.
+class KernelProfile {
+public:
+    explicit KernelProfile(const bool &enabled = false);
+
+    bool enabled() const {
+        return(on);
+    }
+
+    // Start a phase, which stops the running one. Phases of the same name
+    // add up
+    void start(const std::string &phase);
+    void stop();
+    void count(const std::string &counter, const double &value);
+    // The busy time of the calling thread since `begin`, from now()
+    void busy(const double &begin);
+    double now() const;
+
+    // phases, counters, thread_busy and imbalance (the largest busy time of
+    // a thread over the mean)
+    List summary();
+
+private:
+    bool on;
+    vector<std::string> phase_names, counter_names;
+    vector<double> phase_seconds, counter_values, busy_seconds;
+    vector<int> busy_calls;
+    int running = -1;
+    double phase_begin = 0.0;
+};
+
+// Attach the profile of a call to its result as the "profile" attribute, if
+// enabled
+template <typename R> R with_profile(R result, KernelProfile &profile) {
+    if (profile.enabled()) {
+        result.attr("profile") = profile.summary();
+    }
+    return(result);
+}
+
+enum : int {
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_CANCELLED,
+    JOB_FAILED
+};
+
+// A kernel running in the background on the job pool (jobs.cpp). The R
+// session submits it, polls its progress and cancels it, while the kernel
+// runs on a pool thread. Off the main thread only plain C++ is touched: the
+// inputs are copied in before submitting, and `collect` converts the result
+// to R on the main thread
+struct Job {
+    explicit Job(const int &threads = 0) : threads(threads) {}
+
+    // The thread budget of the kernel, 0 for the default, see ThreadScope
+    int threads;
+    std::atomic<int> state{JOB_QUEUED};
+    std::atomic<bool> cancelled{false}, partial_requested{false};
+    // Progress in the units of the kernel, such as sweeps or nodes
+    std::atomic<size_t> done{0}, total{0};
+    double submitted = 0.0, started = 0.0, finished = 0.0;
+
+    // Written by the kernel under the lock, read by the session
+    std::mutex mutex;
+    std::condition_variable changed;
+    vector<double> loss;
+    MatrixXd partial;
+    size_t partial_version = 0;
+    std::string error;
+
+    std::function<void(Job &)> work;
+    std::function<SEXP()> collect;
+};
+
+// The progress and interruption of a kernel: the progress bar and the user
+// interrupts of the R session, or the counters and cancellation of a job,
+// since neither R nor Progress may be touched off the main thread.
+// aborted() and increment() are safe in OpenMP regions
+class KernelMonitor {
+public:
+    KernelMonitor(const size_t &total, const bool &display_progress, Job *job = nullptr) : job(job) {
+        if (job) {
+            job->total = total;
+        } else {
+            progress.reset(new Progress(total, display_progress));
+        }
+    }
+
+    bool aborted() const {
+        return(job ? job->cancelled.load() : Progress::check_abort());
+    }
+    void increment(const size_t &amount = 1) {
+        if (job) {
+            job->done += amount;
+        } else {
+            progress->increment(amount);
+        }
+    }
+    // The latest loss of each seed
+    void report_loss(const vector<double> &loss) {
+        if (job) {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->loss = loss;
+        }
+    }
+    // Whether the session waits for a partial result, which is then built
+    // and published
+    bool partial_requested() const {
+        return(job && job->partial_requested.load());
+    }
+    void publish_partial(MatrixXd partial) {
+        if (job) {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->partial = std::move(partial);
+            job->partial_version++;
+            job->partial_requested = false;
+            job->changed.notify_all();
+        }
+    }
+
+private:
+    Job *job;
+    std::unique_ptr<Progress> progress;
+};
+
+// Queue a job on the pool, which runs up to `workers` jobs at a time, and
+// return the external pointer of its handle
+SEXP submit_job(const std::shared_ptr<Job> &job, const int &workers);
+
+// Memory shared by the session and the worker processes forked from it, for
+// the partitioned kernels (partition.cpp). The session maps it before the
+// fork, so every process finds it at the same address. It holds a barrier of
+// process-shared atomics ahead of `bytes` of arrays, and is unmapped when the
+// R object of the session is collected
+class SharedSegment {
+public:
+    SharedSegment(const size_t &bytes, const int &processes);
+    ~SharedSegment();
+    SharedSegment(const SharedSegment &) = delete;
+    SharedSegment &operator=(const SharedSegment &) = delete;
+
+    // The array at `offset` bytes into the segment
+    template <typename T> T *array(const size_t &offset) {
+        return(reinterpret_cast<T *>(data + offset));
+    }
+    int processes() const;
+    // Wait until every process arrives. It throws if a process has failed,
+    // if the session is interrupted (rank 0) or if it is gone (the workers)
+    void wait(const int &rank);
+    // Mark the run as failed, which releases the processes waiting
+    void fail();
+    // Watch the workers (by rank from 1): wait() fails the run in the
+    // session once one of them exits
+    void watch(const vector<long> &pids);
+
+private:
+    struct Control;
+    Control *control = nullptr;
+    char *data = nullptr;
+    size_t mapped = 0;
+
+    static size_t control_bytes(const int &processes);
+    long *workers() const;
+    bool exited() const;
+};
+
+// The segment of an external pointer from shared_segment(), or an error if
+// it was unmapped
+SharedSegment *shared_segment(SEXP segment);
+SEXP shared_segment(SharedSegment *segment);
+
+// Sums over the rows of the partitioned kernels, such as the L1 step of the
+// random walk, add up the sums of chunks of PARTITION_CHUNK rows in chunk
+// order, and so do the kernels in one process. The rows of every process
+// start at a chunk, so the processes sum whole chunks of their own and the
+// totals do not depend on the partition.
+const Index PARTITION_CHUNK = 256;
+
+inline Index partition_chunks(const Index &rows) {
+    return((rows + PARTITION_CHUNK - 1) / PARTITION_CHUNK);
+}
+
+// The sums of term(row, column) over the chunks of the rows [first, last),
+// the row of chunk c at sums + c * stride. `first` starts a chunk, unless the
+// range is empty, as for a process left without rows
+template <typename Scalar, typename Term>
+inline void chunk_sums(const Term &term, const Index &first, const Index &last, const Index &width, Scalar *sums, const Index &stride) {
+    if (first >= last) {
+        return;
+    }
+    for (Index chunk = first / PARTITION_CHUNK; chunk * PARTITION_CHUNK < last; chunk++) {
+        Scalar *sum = sums + chunk * stride;
+        std::fill(sum, sum + width, Scalar(0));
+        for (Index row = chunk * PARTITION_CHUNK; row < std::min(last, (chunk + 1) * PARTITION_CHUNK); row++) {
+            for (Index column = 0; column < width; column++) {
+                sum[column] += term(row, column);
+            }
+        }
+    }
+}
+
+// The totals of the sums of `chunks` chunks, in chunk order
+template <typename Scalar>
+inline Matrix<Scalar, 1, Dynamic> add_chunks(const Scalar *sums, const Index &chunks, const Index &width, const Index &stride) {
+    Matrix<Scalar, 1, Dynamic> total = Matrix<Scalar, 1, Dynamic>::Zero(width);
+    for (Index chunk = 0; chunk < chunks; chunk++) {
+        total += Map<const Matrix<Scalar, 1, Dynamic>>(sums + chunk * stride, width);
+    }
+    return(total);
+}
+
+// The first row of every process and the end of the rows, in whole chunks
+// with about the same number of edges (plus one per row, as in
+// partition_edges()) per process
+template <typename I>
+vector<Index> partition_rows(const I *outer, const Index &n, const int &processes) {
+    vector<Index> bounds(processes + 1, n);
+    const double total = double(outer[n] - outer[0]) + double(n);
+    double sum = 0.0;
+    Index row = 0;
+    bounds[0] = 0;
+    for (int process = 1; process < processes; process++) {
+        while (row < n && sum < total * process / processes) {
+            Index end = std::min(n, row + PARTITION_CHUNK);
+            sum += double(outer[end] - outer[row]) + double(end - row);
+            row = end;
+        }
+        bounds[process] = row;
+    }
+    return(bounds);
+}
+
+// sum((1 - sigma(ax, ay)) * weight * ax) over the nonzero ax, vectorized by
+// the widest instruction set of the CPU
+double sigmoid_weighted_sum(const double *ax, const size_t &size, const double &ay, const double &weight);
 
 ArrayXi get_neighbors_s(const MSpMat &adj_matrix, const int &node_id, const int neighbor_type = 0);
 ArrayXi get_neighbors_d (const MMatrixXd &adj_matrix, const int &node_id, const int neighbor_type = 0);
 template <typename T> ArrayXi get_neighbors_t(const T &adj_matrix, const int &node_id, const int &neighbor_type);
 vector<double> spread_activation_t(const MSpMat &graph, VectorXd &last_activation, double loose);
-
-#include <diffusr_RcppExports.h>
-
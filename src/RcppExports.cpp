@@ -12,6 +12,64 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// evaluate_holdout_s
+List evaluate_holdout_s(const MSpMat& W, const MSpMat& W_t, const int drug_num, const IntegerVector& diseases, Nullable<List> known, const double r, const double thresh, const int niter, int threads, bool display_progress);
+RcppExport SEXP _labyrinth_evaluate_holdout_s(SEXP WSEXP, SEXP W_tSEXP, SEXP drug_numSEXP, SEXP diseasesSEXP, SEXP knownSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP threadsSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const MSpMat& >::type W_t(W_tSEXP);
+    Rcpp::traits::input_parameter< const int >::type drug_num(drug_numSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type diseases(diseasesSEXP);
+    Rcpp::traits::input_parameter< Nullable<List> >::type known(knownSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(evaluate_holdout_s(W, W_t, drug_num, diseases, known, r, thresh, niter, threads, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// evaluate_holdout_d
+List evaluate_holdout_d(const MMatrixXd& W, const int drug_num, const IntegerVector& diseases, Nullable<List> known, const double r, const double thresh, const int niter, int threads, bool display_progress);
+RcppExport SEXP _labyrinth_evaluate_holdout_d(SEXP WSEXP, SEXP drug_numSEXP, SEXP diseasesSEXP, SEXP knownSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP threadsSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const int >::type drug_num(drug_numSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type diseases(diseasesSEXP);
+    Rcpp::traits::input_parameter< Nullable<List> >::type known(knownSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(evaluate_holdout_d(W, drug_num, diseases, known, r, thresh, niter, threads, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// evaluate_holdout_m
+List evaluate_holdout_m(SEXP store, const int drug_num, const IntegerVector& diseases, Nullable<List> known, const double r, const double thresh, const int niter, int threads, bool display_progress);
+RcppExport SEXP _labyrinth_evaluate_holdout_m(SEXP storeSEXP, SEXP drug_numSEXP, SEXP diseasesSEXP, SEXP knownSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP threadsSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const int >::type drug_num(drug_numSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type diseases(diseasesSEXP);
+    Rcpp::traits::input_parameter< Nullable<List> >::type known(knownSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(evaluate_holdout_m(store, drug_num, diseases, known, r, thresh, niter, threads, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
 // get_neighbors_s
 ArrayXi get_neighbors_s(const MSpMat& adj_matrix, const int& node_id, const int neighbor_type);
 RcppExport SEXP _labyrinth_get_neighbors_s(SEXP adj_matrixSEXP, SEXP node_idSEXP, SEXP neighbor_typeSEXP) {
@@ -38,35 +96,576 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// k_hop_neighbors_s
+List k_hop_neighbors_s(const MSpMat& adj_matrix, const IntegerVector& nodes, const int hops, const int neighbor_type, const bool distance, const int threads);
+RcppExport SEXP _labyrinth_k_hop_neighbors_s(SEXP adj_matrixSEXP, SEXP nodesSEXP, SEXP hopsSEXP, SEXP neighbor_typeSEXP, SEXP distanceSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type adj_matrix(adj_matrixSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type nodes(nodesSEXP);
+    Rcpp::traits::input_parameter< const int >::type hops(hopsSEXP);
+    Rcpp::traits::input_parameter< const int >::type neighbor_type(neighbor_typeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type distance(distanceSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(k_hop_neighbors_s(adj_matrix, nodes, hops, neighbor_type, distance, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// k_hop_neighbors_d
+List k_hop_neighbors_d(const MMatrixXd& adj_matrix, const IntegerVector& nodes, const int hops, const int neighbor_type, const bool distance, const int threads);
+RcppExport SEXP _labyrinth_k_hop_neighbors_d(SEXP adj_matrixSEXP, SEXP nodesSEXP, SEXP hopsSEXP, SEXP neighbor_typeSEXP, SEXP distanceSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type adj_matrix(adj_matrixSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type nodes(nodesSEXP);
+    Rcpp::traits::input_parameter< const int >::type hops(hopsSEXP);
+    Rcpp::traits::input_parameter< const int >::type neighbor_type(neighbor_typeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type distance(distanceSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(k_hop_neighbors_d(adj_matrix, nodes, hops, neighbor_type, distance, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// k_hop_neighbors_m
+List k_hop_neighbors_m(SEXP store, const IntegerVector& nodes, const int hops, const int neighbor_type, const bool distance, const int threads);
+RcppExport SEXP _labyrinth_k_hop_neighbors_m(SEXP storeSEXP, SEXP nodesSEXP, SEXP hopsSEXP, SEXP neighbor_typeSEXP, SEXP distanceSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type nodes(nodesSEXP);
+    Rcpp::traits::input_parameter< const int >::type hops(hopsSEXP);
+    Rcpp::traits::input_parameter< const int >::type neighbor_type(neighbor_typeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type distance(distanceSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(k_hop_neighbors_m(store, nodes, hops, neighbor_type, distance, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// seed_ball_s
+List seed_ball_s(const MSpMat& matrix, const MMatrixXd& p0, const int hops, const double epsilon, const double decay, const bool transition, const int threads);
+RcppExport SEXP _labyrinth_seed_ball_s(SEXP matrixSEXP, SEXP p0SEXP, SEXP hopsSEXP, SEXP epsilonSEXP, SEXP decaySEXP, SEXP transitionSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type matrix(matrixSEXP);
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const int >::type hops(hopsSEXP);
+    Rcpp::traits::input_parameter< const double >::type epsilon(epsilonSEXP);
+    Rcpp::traits::input_parameter< const double >::type decay(decaySEXP);
+    Rcpp::traits::input_parameter< const bool >::type transition(transitionSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(seed_ball_s(matrix, p0, hops, epsilon, decay, transition, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// seed_ball_d
+List seed_ball_d(const MMatrixXd& matrix, const MMatrixXd& p0, const int hops, const double epsilon, const double decay, const bool transition, const int threads);
+RcppExport SEXP _labyrinth_seed_ball_d(SEXP matrixSEXP, SEXP p0SEXP, SEXP hopsSEXP, SEXP epsilonSEXP, SEXP decaySEXP, SEXP transitionSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type matrix(matrixSEXP);
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const int >::type hops(hopsSEXP);
+    Rcpp::traits::input_parameter< const double >::type epsilon(epsilonSEXP);
+    Rcpp::traits::input_parameter< const double >::type decay(decaySEXP);
+    Rcpp::traits::input_parameter< const bool >::type transition(transitionSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(seed_ball_d(matrix, p0, hops, epsilon, decay, transition, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// seed_ball_m
+List seed_ball_m(SEXP store, const MMatrixXd& p0, const int hops, const double epsilon, const double decay, const bool transition, const int threads);
+RcppExport SEXP _labyrinth_seed_ball_m(SEXP storeSEXP, SEXP p0SEXP, SEXP hopsSEXP, SEXP epsilonSEXP, SEXP decaySEXP, SEXP transitionSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const int >::type hops(hopsSEXP);
+    Rcpp::traits::input_parameter< const double >::type epsilon(epsilonSEXP);
+    Rcpp::traits::input_parameter< const double >::type decay(decaySEXP);
+    Rcpp::traits::input_parameter< const bool >::type transition(transitionSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(seed_ball_m(store, p0, hops, epsilon, decay, transition, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// neighbor_lists_s
+SEXP neighbor_lists_s(const MSpMat& graph, const int threads);
+RcppExport SEXP _labyrinth_neighbor_lists_s(SEXP graphSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(neighbor_lists_s(graph, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// neighbor_lists_d
+SEXP neighbor_lists_d(const MMatrixXd& graph, const int threads);
+RcppExport SEXP _labyrinth_neighbor_lists_d(SEXP graphSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(neighbor_lists_d(graph, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// neighbor_lists_m
+SEXP neighbor_lists_m(SEXP store, const int threads);
+RcppExport SEXP _labyrinth_neighbor_lists_m(SEXP storeSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(neighbor_lists_m(store, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// seed_ball_n
+List seed_ball_n(SEXP neighbors, const MMatrixXd& p0, const int hops, const double epsilon, const double decay);
+RcppExport SEXP _labyrinth_seed_ball_n(SEXP neighborsSEXP, SEXP p0SEXP, SEXP hopsSEXP, SEXP epsilonSEXP, SEXP decaySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type neighbors(neighborsSEXP);
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const int >::type hops(hopsSEXP);
+    Rcpp::traits::input_parameter< const double >::type epsilon(epsilonSEXP);
+    Rcpp::traits::input_parameter< const double >::type decay(decaySEXP);
+    rcpp_result_gen = Rcpp::wrap(seed_ball_n(neighbors, p0, hops, epsilon, decay));
+    return rcpp_result_gen;
+END_RCPP
+}
+// induced_subgraph_m
+SpMat induced_subgraph_m(SEXP store, const IntegerVector& nodes);
+RcppExport SEXP _labyrinth_induced_subgraph_m(SEXP storeSEXP, SEXP nodesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type nodes(nodesSEXP);
+    rcpp_result_gen = Rcpp::wrap(induced_subgraph_m(store, nodes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// graph_order_s
+IntegerVector graph_order_s(const MSpMat& graph, const std::string& method, const bool fix_first);
+RcppExport SEXP _labyrinth_graph_order_s(SEXP graphSEXP, SEXP methodSEXP, SEXP fix_firstSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< const bool >::type fix_first(fix_firstSEXP);
+    rcpp_result_gen = Rcpp::wrap(graph_order_s(graph, method, fix_first));
+    return rcpp_result_gen;
+END_RCPP
+}
+// graph_order_d
+IntegerVector graph_order_d(const MMatrixXd& graph, const std::string& method, const bool fix_first);
+RcppExport SEXP _labyrinth_graph_order_d(SEXP graphSEXP, SEXP methodSEXP, SEXP fix_firstSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< const bool >::type fix_first(fix_firstSEXP);
+    rcpp_result_gen = Rcpp::wrap(graph_order_d(graph, method, fix_first));
+    return rcpp_result_gen;
+END_RCPP
+}
+// write_graph_store_
+double write_graph_store_(const List& matrices, const CharacterVector& names, const std::string& path);
+RcppExport SEXP _labyrinth_write_graph_store_(SEXP matricesSEXP, SEXP namesSEXP, SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const List& >::type matrices(matricesSEXP);
+    Rcpp::traits::input_parameter< const CharacterVector& >::type names(namesSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(write_graph_store_(matrices, names, path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// open_graph_store_
+List open_graph_store_(const std::string& path);
+RcppExport SEXP _labyrinth_open_graph_store_(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(open_graph_store_(path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// graph_store_links_
+NumericVector graph_store_links_(SEXP store, const int& node);
+RcppExport SEXP _labyrinth_graph_store_links_(SEXP storeSEXP, SEXP nodeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const int& >::type node(nodeSEXP);
+    rcpp_result_gen = Rcpp::wrap(graph_store_links_(store, node));
+    return rcpp_result_gen;
+END_RCPP
+}
+// job_status_
+List job_status_(SEXP job);
+RcppExport SEXP _labyrinth_job_status_(SEXP jobSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type job(jobSEXP);
+    rcpp_result_gen = Rcpp::wrap(job_status_(job));
+    return rcpp_result_gen;
+END_RCPP
+}
+// job_cancel_
+bool job_cancel_(SEXP job);
+RcppExport SEXP _labyrinth_job_cancel_(SEXP jobSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type job(jobSEXP);
+    rcpp_result_gen = Rcpp::wrap(job_cancel_(job));
+    return rcpp_result_gen;
+END_RCPP
+}
+// job_result_
+SEXP job_result_(SEXP job, const double timeout);
+RcppExport SEXP _labyrinth_job_result_(SEXP jobSEXP, SEXP timeoutSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type job(jobSEXP);
+    Rcpp::traits::input_parameter< const double >::type timeout(timeoutSEXP);
+    rcpp_result_gen = Rcpp::wrap(job_result_(job, timeout));
+    return rcpp_result_gen;
+END_RCPP
+}
+// job_partial_
+SEXP job_partial_(SEXP job, const double timeout);
+RcppExport SEXP _labyrinth_job_partial_(SEXP jobSEXP, SEXP timeoutSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type job(jobSEXP);
+    Rcpp::traits::input_parameter< const double >::type timeout(timeoutSEXP);
+    rcpp_result_gen = Rcpp::wrap(job_partial_(job, timeout));
+    return rcpp_result_gen;
+END_RCPP
+}
+// shared_segment_fail_
+void shared_segment_fail_(SEXP segment);
+RcppExport SEXP _labyrinth_shared_segment_fail_(SEXP segmentSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type segment(segmentSEXP);
+    shared_segment_fail_(segment);
+    return R_NilValue;
+END_RCPP
+}
+// shared_segment_watch_
+void shared_segment_watch_(SEXP segment, const NumericVector& pids);
+RcppExport SEXP _labyrinth_shared_segment_watch_(SEXP segmentSEXP, SEXP pidsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type segment(segmentSEXP);
+    Rcpp::traits::input_parameter< const NumericVector& >::type pids(pidsSEXP);
+    shared_segment_watch_(segment, pids);
+    return R_NilValue;
+END_RCPP
+}
 // mrwr_
-VectorXd mrwr_(const MatrixXd& p0, const MatrixXd& W, const double r, const double thresh, const int niter, const bool do_analytical);
-RcppExport SEXP _labyrinth_mrwr_(SEXP p0SEXP, SEXP WSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP do_analyticalSEXP) {
+List mrwr_(const MatrixXd& p0, const MMatrixXd& W, const double r, const double thresh, const int niter, const bool do_analytical, int threads, Nullable<NumericMatrix> start);
+RcppExport SEXP _labyrinth_mrwr_(SEXP p0SEXP, SEXP WSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP do_analyticalSEXP, SEXP threadsSEXP, SEXP startSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const MatrixXd& >::type p0(p0SEXP);
-    Rcpp::traits::input_parameter< const MatrixXd& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type W(WSEXP);
     Rcpp::traits::input_parameter< const double >::type r(rSEXP);
     Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
     Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
     Rcpp::traits::input_parameter< const bool >::type do_analytical(do_analyticalSEXP);
-    rcpp_result_gen = Rcpp::wrap(mrwr_(p0, W, r, thresh, niter, do_analytical));
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type start(startSEXP);
+    rcpp_result_gen = Rcpp::wrap(mrwr_(p0, W, r, thresh, niter, do_analytical, threads, start));
     return rcpp_result_gen;
 END_RCPP
 }
 // mrwr_s
-VectorXd mrwr_s(const MatrixXd& p0, const SpMat& W, const double r, const double thresh, const int niter, const bool do_analytical);
-RcppExport SEXP _labyrinth_mrwr_s(SEXP p0SEXP, SEXP WSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP do_analyticalSEXP) {
+List mrwr_s(const MatrixXd& p0, const MSpMat& W_t, const double r, const double thresh, const int niter, const bool do_analytical, int threads, Nullable<NumericMatrix> start);
+RcppExport SEXP _labyrinth_mrwr_s(SEXP p0SEXP, SEXP W_tSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP do_analyticalSEXP, SEXP threadsSEXP, SEXP startSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const MSpMat& >::type W_t(W_tSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< const bool >::type do_analytical(do_analyticalSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type start(startSEXP);
+    rcpp_result_gen = Rcpp::wrap(mrwr_s(p0, W_t, r, thresh, niter, do_analytical, threads, start));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ppr_push_
+List ppr_push_(const MMatrixXd& p0, const MMatrixXd& W, const double r, const double epsilon, int threads);
+RcppExport SEXP _labyrinth_ppr_push_(SEXP p0SEXP, SEXP WSEXP, SEXP rSEXP, SEXP epsilonSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type epsilon(epsilonSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ppr_push_(p0, W, r, epsilon, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ppr_push_s
+List ppr_push_s(const MMatrixXd& p0, const MSpMat& W, const double r, const double epsilon, int threads);
+RcppExport SEXP _labyrinth_ppr_push_s(SEXP p0SEXP, SEXP WSEXP, SEXP rSEXP, SEXP epsilonSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const MSpMat& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type epsilon(epsilonSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ppr_push_s(p0, W, r, epsilon, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// mrwr_m
+List mrwr_m(const MatrixXd& p0, SEXP store, const double r, const double thresh, const int niter, const bool do_analytical, int threads, Nullable<NumericMatrix> start);
+RcppExport SEXP _labyrinth_mrwr_m(SEXP p0SEXP, SEXP storeSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP do_analyticalSEXP, SEXP threadsSEXP, SEXP startSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const MatrixXd& >::type p0(p0SEXP);
-    Rcpp::traits::input_parameter< const SpMat& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
     Rcpp::traits::input_parameter< const double >::type r(rSEXP);
     Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
     Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
     Rcpp::traits::input_parameter< const bool >::type do_analytical(do_analyticalSEXP);
-    rcpp_result_gen = Rcpp::wrap(mrwr_s(p0, W, r, thresh, niter, do_analytical));
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type start(startSEXP);
+    rcpp_result_gen = Rcpp::wrap(mrwr_m(p0, store, r, thresh, niter, do_analytical, threads, start));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ppr_push_m
+List ppr_push_m(const MMatrixXd& p0, SEXP store, const double r, const double epsilon, int threads);
+RcppExport SEXP _labyrinth_ppr_push_m(SEXP p0SEXP, SEXP storeSEXP, SEXP rSEXP, SEXP epsilonSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type epsilon(epsilonSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ppr_push_m(p0, store, r, epsilon, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// walk_segment_s
+SEXP walk_segment_s(const MSpMat& W_t, const int seeds, const int processes);
+RcppExport SEXP _labyrinth_walk_segment_s(SEXP W_tSEXP, SEXP seedsSEXP, SEXP processesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type W_t(W_tSEXP);
+    Rcpp::traits::input_parameter< const int >::type seeds(seedsSEXP);
+    Rcpp::traits::input_parameter< const int >::type processes(processesSEXP);
+    rcpp_result_gen = Rcpp::wrap(walk_segment_s(W_t, seeds, processes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// walk_segment_m
+SEXP walk_segment_m(SEXP store, const int seeds, const int processes);
+RcppExport SEXP _labyrinth_walk_segment_m(SEXP storeSEXP, SEXP seedsSEXP, SEXP processesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const int >::type seeds(seedsSEXP);
+    Rcpp::traits::input_parameter< const int >::type processes(processesSEXP);
+    rcpp_result_gen = Rcpp::wrap(walk_segment_m(store, seeds, processes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// walk_partition_s
+List walk_partition_s(SEXP segment, const int rank, const MSpMat& W_t, const double r, Nullable<NumericMatrix> p0, const double thresh, const int niter, Nullable<NumericMatrix> start, const int threads);
+RcppExport SEXP _labyrinth_walk_partition_s(SEXP segmentSEXP, SEXP rankSEXP, SEXP W_tSEXP, SEXP rSEXP, SEXP p0SEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP startSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type segment(segmentSEXP);
+    Rcpp::traits::input_parameter< const int >::type rank(rankSEXP);
+    Rcpp::traits::input_parameter< const MSpMat& >::type W_t(W_tSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type start(startSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(walk_partition_s(segment, rank, W_t, r, p0, thresh, niter, start, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// walk_partition_m
+List walk_partition_m(SEXP segment, const int rank, SEXP store, const double r, Nullable<NumericMatrix> p0, const double thresh, const int niter, Nullable<NumericMatrix> start, const int threads);
+RcppExport SEXP _labyrinth_walk_partition_m(SEXP segmentSEXP, SEXP rankSEXP, SEXP storeSEXP, SEXP rSEXP, SEXP p0SEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP startSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type segment(segmentSEXP);
+    Rcpp::traits::input_parameter< const int >::type rank(rankSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type start(startSEXP);
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(walk_partition_m(segment, rank, store, r, p0, thresh, niter, start, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// transpose_transition_
+SpMat transpose_transition_(const MSpMat& W);
+RcppExport SEXP _labyrinth_transpose_transition_(SEXP WSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type W(WSEXP);
+    rcpp_result_gen = Rcpp::wrap(transpose_transition_(W));
+    return rcpp_result_gen;
+END_RCPP
+}
+// float_transition_s
+SEXP float_transition_s(const MSpMat& W_t);
+RcppExport SEXP _labyrinth_float_transition_s(SEXP W_tSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type W_t(W_tSEXP);
+    rcpp_result_gen = Rcpp::wrap(float_transition_s(W_t));
+    return rcpp_result_gen;
+END_RCPP
+}
+// float_transition_d
+SEXP float_transition_d(const MMatrixXd& W);
+RcppExport SEXP _labyrinth_float_transition_d(SEXP WSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type W(WSEXP);
+    rcpp_result_gen = Rcpp::wrap(float_transition_d(W));
+    return rcpp_result_gen;
+END_RCPP
+}
+// float_transition_m
+SEXP float_transition_m(SEXP store);
+RcppExport SEXP _labyrinth_float_transition_m(SEXP storeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    rcpp_result_gen = Rcpp::wrap(float_transition_m(store));
+    return rcpp_result_gen;
+END_RCPP
+}
+// mrwr_f
+List mrwr_f(const MatrixXd& p0, SEXP transition, const double r, const double thresh, const int niter, int threads, Nullable<NumericMatrix> start);
+RcppExport SEXP _labyrinth_mrwr_f(SEXP p0SEXP, SEXP transitionSEXP, SEXP rSEXP, SEXP threshSEXP, SEXP niterSEXP, SEXP threadsSEXP, SEXP startSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MatrixXd& >::type p0(p0SEXP);
+    Rcpp::traits::input_parameter< SEXP >::type transition(transitionSEXP);
+    Rcpp::traits::input_parameter< const double >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< const int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type start(startSEXP);
+    rcpp_result_gen = Rcpp::wrap(mrwr_f(p0, transition, r, thresh, niter, threads, start));
+    return rcpp_result_gen;
+END_RCPP
+}
+// hash_columns_
+CharacterVector hash_columns_(const MMatrixXd& x);
+RcppExport SEXP _labyrinth_hash_columns_(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(hash_columns_(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// hash_graph_d
+std::string hash_graph_d(const MMatrixXd& graph);
+RcppExport SEXP _labyrinth_hash_graph_d(SEXP graphSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type graph(graphSEXP);
+    rcpp_result_gen = Rcpp::wrap(hash_graph_d(graph));
+    return rcpp_result_gen;
+END_RCPP
+}
+// hash_graph_s
+std::string hash_graph_s(const MSpMat& graph);
+RcppExport SEXP _labyrinth_hash_graph_s(SEXP graphSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type graph(graphSEXP);
+    rcpp_result_gen = Rcpp::wrap(hash_graph_s(graph));
+    return rcpp_result_gen;
+END_RCPP
+}
+// hash_strings_
+CharacterVector hash_strings_(const CharacterVector& x);
+RcppExport SEXP _labyrinth_hash_strings_(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const CharacterVector& >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(hash_strings_(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sigmoid_sum_
+NumericVector sigmoid_sum_(const NumericVector& ax, const double ay, const double weight, const bool scalar);
+RcppExport SEXP _labyrinth_sigmoid_sum_(SEXP axSEXP, SEXP aySEXP, SEXP weightSEXP, SEXP scalarSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const NumericVector& >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< const double >::type ay(aySEXP);
+    Rcpp::traits::input_parameter< const double >::type weight(weightSEXP);
+    Rcpp::traits::input_parameter< const bool >::type scalar(scalarSEXP);
+    rcpp_result_gen = Rcpp::wrap(sigmoid_sum_(ax, ay, weight, scalar));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -101,36 +700,151 @@ BEGIN_RCPP
 END_RCPP
 }
 // activation_rate_s
-VectorXd activation_rate_s(MSpMat& graph, const ArrayXd& strength, const ArrayXd& stm, const double loose, int threads, bool remove_first, bool display_progress);
-RcppExport SEXP _labyrinth_activation_rate_s(SEXP graphSEXP, SEXP strengthSEXP, SEXP stmSEXP, SEXP looseSEXP, SEXP threadsSEXP, SEXP remove_firstSEXP, SEXP display_progressSEXP) {
+SEXP activation_rate_s(MSpMat& graph, const MatrixXd& strength, const MatrixXd& stm, const double loose, int threads, bool remove_first, double tol, int max_iter, bool display_progress, std::string reorder, Nullable<NumericMatrix> previous, Nullable<List> changed, bool profile, int async);
+RcppExport SEXP _labyrinth_activation_rate_s(SEXP graphSEXP, SEXP strengthSEXP, SEXP stmSEXP, SEXP looseSEXP, SEXP threadsSEXP, SEXP remove_firstSEXP, SEXP tolSEXP, SEXP max_iterSEXP, SEXP display_progressSEXP, SEXP reorderSEXP, SEXP previousSEXP, SEXP changedSEXP, SEXP profileSEXP, SEXP asyncSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< MSpMat& >::type graph(graphSEXP);
-    Rcpp::traits::input_parameter< const ArrayXd& >::type strength(strengthSEXP);
-    Rcpp::traits::input_parameter< const ArrayXd& >::type stm(stmSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type strength(strengthSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type stm(stmSEXP);
     Rcpp::traits::input_parameter< const double >::type loose(looseSEXP);
     Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
     Rcpp::traits::input_parameter< bool >::type remove_first(remove_firstSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
-    rcpp_result_gen = Rcpp::wrap(activation_rate_s(graph, strength, stm, loose, threads, remove_first, display_progress));
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type previous(previousSEXP);
+    Rcpp::traits::input_parameter< Nullable<List> >::type changed(changedSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< int >::type async(asyncSEXP);
+    rcpp_result_gen = Rcpp::wrap(activation_rate_s(graph, strength, stm, loose, threads, remove_first, tol, max_iter, display_progress, reorder, previous, changed, profile, async));
     return rcpp_result_gen;
 END_RCPP
 }
 // activation_rate_d
-VectorXd activation_rate_d(MMatrixXd& graph, const ArrayXd& strength, const ArrayXd& stm, const double loose, int threads, bool remove_first, bool display_progress);
-RcppExport SEXP _labyrinth_activation_rate_d(SEXP graphSEXP, SEXP strengthSEXP, SEXP stmSEXP, SEXP looseSEXP, SEXP threadsSEXP, SEXP remove_firstSEXP, SEXP display_progressSEXP) {
+SEXP activation_rate_d(MMatrixXd& graph, const MatrixXd& strength, const MatrixXd& stm, const double loose, int threads, bool remove_first, double tol, int max_iter, bool display_progress, std::string reorder, Nullable<NumericMatrix> previous, Nullable<List> changed, bool profile, int async);
+RcppExport SEXP _labyrinth_activation_rate_d(SEXP graphSEXP, SEXP strengthSEXP, SEXP stmSEXP, SEXP looseSEXP, SEXP threadsSEXP, SEXP remove_firstSEXP, SEXP tolSEXP, SEXP max_iterSEXP, SEXP display_progressSEXP, SEXP reorderSEXP, SEXP previousSEXP, SEXP changedSEXP, SEXP profileSEXP, SEXP asyncSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< MMatrixXd& >::type graph(graphSEXP);
-    Rcpp::traits::input_parameter< const ArrayXd& >::type strength(strengthSEXP);
-    Rcpp::traits::input_parameter< const ArrayXd& >::type stm(stmSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type strength(strengthSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type stm(stmSEXP);
+    Rcpp::traits::input_parameter< const double >::type loose(looseSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type remove_first(remove_firstSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type previous(previousSEXP);
+    Rcpp::traits::input_parameter< Nullable<List> >::type changed(changedSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< int >::type async(asyncSEXP);
+    rcpp_result_gen = Rcpp::wrap(activation_rate_d(graph, strength, stm, loose, threads, remove_first, tol, max_iter, display_progress, reorder, previous, changed, profile, async));
+    return rcpp_result_gen;
+END_RCPP
+}
+// activation_rate_m
+SEXP activation_rate_m(SEXP store, const MatrixXd& strength, const MatrixXd& stm, const double loose, int threads, bool remove_first, double tol, int max_iter, bool display_progress, std::string reorder, Nullable<NumericMatrix> previous, Nullable<List> changed, bool profile, int async);
+RcppExport SEXP _labyrinth_activation_rate_m(SEXP storeSEXP, SEXP strengthSEXP, SEXP stmSEXP, SEXP looseSEXP, SEXP threadsSEXP, SEXP remove_firstSEXP, SEXP tolSEXP, SEXP max_iterSEXP, SEXP display_progressSEXP, SEXP reorderSEXP, SEXP previousSEXP, SEXP changedSEXP, SEXP profileSEXP, SEXP asyncSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type strength(strengthSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type stm(stmSEXP);
     Rcpp::traits::input_parameter< const double >::type loose(looseSEXP);
     Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
     Rcpp::traits::input_parameter< bool >::type remove_first(remove_firstSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
-    rcpp_result_gen = Rcpp::wrap(activation_rate_d(graph, strength, stm, loose, threads, remove_first, display_progress));
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericMatrix> >::type previous(previousSEXP);
+    Rcpp::traits::input_parameter< Nullable<List> >::type changed(changedSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< int >::type async(asyncSEXP);
+    rcpp_result_gen = Rcpp::wrap(activation_rate_m(store, strength, stm, loose, threads, remove_first, tol, max_iter, display_progress, reorder, previous, changed, profile, async));
+    return rcpp_result_gen;
+END_RCPP
+}
+// activation_rate_problem_s
+SEXP activation_rate_problem_s(MSpMat& graph, const MatrixXd& strength, const MatrixXd& stm, bool remove_first, std::string reorder, int threads);
+RcppExport SEXP _labyrinth_activation_rate_problem_s(SEXP graphSEXP, SEXP strengthSEXP, SEXP stmSEXP, SEXP remove_firstSEXP, SEXP reorderSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< MSpMat& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type strength(strengthSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type stm(stmSEXP);
+    Rcpp::traits::input_parameter< bool >::type remove_first(remove_firstSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(activation_rate_problem_s(graph, strength, stm, remove_first, reorder, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// activation_rate_problem_d
+SEXP activation_rate_problem_d(MMatrixXd& graph, const MatrixXd& strength, const MatrixXd& stm, bool remove_first, std::string reorder, int threads);
+RcppExport SEXP _labyrinth_activation_rate_problem_d(SEXP graphSEXP, SEXP strengthSEXP, SEXP stmSEXP, SEXP remove_firstSEXP, SEXP reorderSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< MMatrixXd& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type strength(strengthSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type stm(stmSEXP);
+    Rcpp::traits::input_parameter< bool >::type remove_first(remove_firstSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(activation_rate_problem_d(graph, strength, stm, remove_first, reorder, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// activation_rate_problem_m
+SEXP activation_rate_problem_m(SEXP store, const MatrixXd& strength, const MatrixXd& stm, bool remove_first, std::string reorder, int threads);
+RcppExport SEXP _labyrinth_activation_rate_problem_m(SEXP storeSEXP, SEXP strengthSEXP, SEXP stmSEXP, SEXP remove_firstSEXP, SEXP reorderSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type strength(strengthSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type stm(stmSEXP);
+    Rcpp::traits::input_parameter< bool >::type remove_first(remove_firstSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(activation_rate_problem_m(store, strength, stm, remove_first, reorder, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// activation_rate_segment_
+SEXP activation_rate_segment_(SEXP problem, const int processes);
+RcppExport SEXP _labyrinth_activation_rate_segment_(SEXP problemSEXP, SEXP processesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type problem(problemSEXP);
+    Rcpp::traits::input_parameter< const int >::type processes(processesSEXP);
+    rcpp_result_gen = Rcpp::wrap(activation_rate_segment_(problem, processes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// activation_rate_partition_
+List activation_rate_partition_(SEXP segment, const int rank, SEXP problem, double loose, double tol, int max_iter, int threads);
+RcppExport SEXP _labyrinth_activation_rate_partition_(SEXP segmentSEXP, SEXP rankSEXP, SEXP problemSEXP, SEXP looseSEXP, SEXP tolSEXP, SEXP max_iterSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type segment(segmentSEXP);
+    Rcpp::traits::input_parameter< const int >::type rank(rankSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type problem(problemSEXP);
+    Rcpp::traits::input_parameter< double >::type loose(looseSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(activation_rate_partition_(segment, rank, problem, loose, tol, max_iter, threads));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -178,8 +892,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // gradient_s
-double gradient_s(const MSpMat& graph, ArrayXd& activation, int threads, bool display_progress);
-RcppExport SEXP _labyrinth_gradient_s(SEXP graphSEXP, SEXP activationSEXP, SEXP threadsSEXP, SEXP display_progressSEXP) {
+NumericVector gradient_s(const MSpMat& graph, ArrayXd& activation, int threads, bool display_progress, bool profile);
+RcppExport SEXP _labyrinth_gradient_s(SEXP graphSEXP, SEXP activationSEXP, SEXP threadsSEXP, SEXP display_progressSEXP, SEXP profileSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -187,13 +901,14 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< ArrayXd& >::type activation(activationSEXP);
     Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
-    rcpp_result_gen = Rcpp::wrap(gradient_s(graph, activation, threads, display_progress));
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    rcpp_result_gen = Rcpp::wrap(gradient_s(graph, activation, threads, display_progress, profile));
     return rcpp_result_gen;
 END_RCPP
 }
 // gradient_d
-double gradient_d(const MMatrixXd& graph, ArrayXd& activation, int threads, bool display_progress);
-RcppExport SEXP _labyrinth_gradient_d(SEXP graphSEXP, SEXP activationSEXP, SEXP threadsSEXP, SEXP display_progressSEXP) {
+NumericVector gradient_d(const MMatrixXd& graph, ArrayXd& activation, int threads, bool display_progress, bool profile);
+RcppExport SEXP _labyrinth_gradient_d(SEXP graphSEXP, SEXP activationSEXP, SEXP threadsSEXP, SEXP display_progressSEXP, SEXP profileSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -201,25 +916,285 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< ArrayXd& >::type activation(activationSEXP);
     Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
-    rcpp_result_gen = Rcpp::wrap(gradient_d(graph, activation, threads, display_progress));
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    rcpp_result_gen = Rcpp::wrap(gradient_d(graph, activation, threads, display_progress, profile));
+    return rcpp_result_gen;
+END_RCPP
+}
+// spread_gram_iter_s
+SEXP spread_gram_iter_s(const MSpMat& graph, const MatrixXd& last_activation, double loose, int max_iter, double threshold, int threads, bool display_progress, std::string reorder, bool profile, int async);
+RcppExport SEXP _labyrinth_spread_gram_iter_s(SEXP graphSEXP, SEXP last_activationSEXP, SEXP looseSEXP, SEXP max_iterSEXP, SEXP thresholdSEXP, SEXP threadsSEXP, SEXP display_progressSEXP, SEXP reorderSEXP, SEXP profileSEXP, SEXP asyncSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type last_activation(last_activationSEXP);
+    Rcpp::traits::input_parameter< double >::type loose(looseSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< int >::type async(asyncSEXP);
+    rcpp_result_gen = Rcpp::wrap(spread_gram_iter_s(graph, last_activation, loose, max_iter, threshold, threads, display_progress, reorder, profile, async));
+    return rcpp_result_gen;
+END_RCPP
+}
+// spread_gram_iter_d
+SEXP spread_gram_iter_d(const MMatrixXd& graph, const MatrixXd& last_activation, double loose, int max_iter, double threshold, int threads, bool display_progress, std::string reorder, bool profile, int async);
+RcppExport SEXP _labyrinth_spread_gram_iter_d(SEXP graphSEXP, SEXP last_activationSEXP, SEXP looseSEXP, SEXP max_iterSEXP, SEXP thresholdSEXP, SEXP threadsSEXP, SEXP display_progressSEXP, SEXP reorderSEXP, SEXP profileSEXP, SEXP asyncSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type last_activation(last_activationSEXP);
+    Rcpp::traits::input_parameter< double >::type loose(looseSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< int >::type async(asyncSEXP);
+    rcpp_result_gen = Rcpp::wrap(spread_gram_iter_d(graph, last_activation, loose, max_iter, threshold, threads, display_progress, reorder, profile, async));
+    return rcpp_result_gen;
+END_RCPP
+}
+// spread_gram_iter_m
+SEXP spread_gram_iter_m(SEXP store, const MatrixXd& last_activation, double loose, int max_iter, double threshold, int threads, bool display_progress, std::string reorder, bool profile, int async);
+RcppExport SEXP _labyrinth_spread_gram_iter_m(SEXP storeSEXP, SEXP last_activationSEXP, SEXP looseSEXP, SEXP max_iterSEXP, SEXP thresholdSEXP, SEXP threadsSEXP, SEXP display_progressSEXP, SEXP reorderSEXP, SEXP profileSEXP, SEXP asyncSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type last_activation(last_activationSEXP);
+    Rcpp::traits::input_parameter< double >::type loose(looseSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< int >::type async(asyncSEXP);
+    rcpp_result_gen = Rcpp::wrap(spread_gram_iter_m(store, last_activation, loose, max_iter, threshold, threads, display_progress, reorder, profile, async));
+    return rcpp_result_gen;
+END_RCPP
+}
+// spread_gram_problem_s
+SEXP spread_gram_problem_s(const MSpMat& graph, const MatrixXd& last_activation, std::string reorder, int threads);
+RcppExport SEXP _labyrinth_spread_gram_problem_s(SEXP graphSEXP, SEXP last_activationSEXP, SEXP reorderSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MSpMat& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type last_activation(last_activationSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(spread_gram_problem_s(graph, last_activation, reorder, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// spread_gram_problem_d
+SEXP spread_gram_problem_d(const MMatrixXd& graph, const MatrixXd& last_activation, std::string reorder, int threads);
+RcppExport SEXP _labyrinth_spread_gram_problem_d(SEXP graphSEXP, SEXP last_activationSEXP, SEXP reorderSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type last_activation(last_activationSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(spread_gram_problem_d(graph, last_activation, reorder, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// spread_gram_problem_m
+SEXP spread_gram_problem_m(SEXP store, const MatrixXd& last_activation, std::string reorder, int threads);
+RcppExport SEXP _labyrinth_spread_gram_problem_m(SEXP storeSEXP, SEXP last_activationSEXP, SEXP reorderSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type store(storeSEXP);
+    Rcpp::traits::input_parameter< const MatrixXd& >::type last_activation(last_activationSEXP);
+    Rcpp::traits::input_parameter< std::string >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(spread_gram_problem_m(store, last_activation, reorder, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// spread_gram_segment_
+SEXP spread_gram_segment_(SEXP problem, const int processes);
+RcppExport SEXP _labyrinth_spread_gram_segment_(SEXP problemSEXP, SEXP processesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type problem(problemSEXP);
+    Rcpp::traits::input_parameter< const int >::type processes(processesSEXP);
+    rcpp_result_gen = Rcpp::wrap(spread_gram_segment_(problem, processes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// spread_gram_partition_
+List spread_gram_partition_(SEXP segment, const int rank, SEXP problem, double loose, int max_iter, double threshold, int threads);
+RcppExport SEXP _labyrinth_spread_gram_partition_(SEXP segmentSEXP, SEXP rankSEXP, SEXP problemSEXP, SEXP looseSEXP, SEXP max_iterSEXP, SEXP thresholdSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type segment(segmentSEXP);
+    Rcpp::traits::input_parameter< const int >::type rank(rankSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type problem(problemSEXP);
+    Rcpp::traits::input_parameter< double >::type loose(looseSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(spread_gram_partition_(segment, rank, problem, loose, max_iter, threshold, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// erdos_renyi_
+SpMat erdos_renyi_(const int n, const double p, const bool weighted);
+RcppExport SEXP _labyrinth_erdos_renyi_(SEXP nSEXP, SEXP pSEXP, SEXP weightedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const double >::type p(pSEXP);
+    Rcpp::traits::input_parameter< const bool >::type weighted(weightedSEXP);
+    rcpp_result_gen = Rcpp::wrap(erdos_renyi_(n, p, weighted));
+    return rcpp_result_gen;
+END_RCPP
+}
+// barabasi_albert_
+SpMat barabasi_albert_(const int n, const int m, const bool weighted);
+RcppExport SEXP _labyrinth_barabasi_albert_(SEXP nSEXP, SEXP mSEXP, SEXP weightedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const int >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const bool >::type weighted(weightedSEXP);
+    rcpp_result_gen = Rcpp::wrap(barabasi_albert_(n, m, weighted));
+    return rcpp_result_gen;
+END_RCPP
+}
+// bipartite_graph_
+SpMat bipartite_graph_(const int drugs, const int diseases, const double edges, const double exponent, const bool weighted);
+RcppExport SEXP _labyrinth_bipartite_graph_(SEXP drugsSEXP, SEXP diseasesSEXP, SEXP edgesSEXP, SEXP exponentSEXP, SEXP weightedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type drugs(drugsSEXP);
+    Rcpp::traits::input_parameter< const int >::type diseases(diseasesSEXP);
+    Rcpp::traits::input_parameter< const double >::type edges(edgesSEXP);
+    Rcpp::traits::input_parameter< const double >::type exponent(exponentSEXP);
+    Rcpp::traits::input_parameter< const bool >::type weighted(weightedSEXP);
+    rcpp_result_gen = Rcpp::wrap(bipartite_graph_(drugs, diseases, edges, exponent, weighted));
+    return rcpp_result_gen;
+END_RCPP
+}
+// thread_options_
+List thread_options_(const int threads, const std::string binding);
+RcppExport SEXP _labyrinth_thread_options_(SEXP threadsSEXP, SEXP bindingSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type binding(bindingSEXP);
+    rcpp_result_gen = Rcpp::wrap(thread_options_(threads, binding));
+    return rcpp_result_gen;
+END_RCPP
+}
+// top_k_
+List top_k_(const MMatrixXd& weights, const int k, int threads);
+RcppExport SEXP _labyrinth_top_k_(SEXP weightsSEXP, SEXP kSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const MMatrixXd& >::type weights(weightsSEXP);
+    Rcpp::traits::input_parameter< const int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(top_k_(weights, k, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
+    {"_labyrinth_evaluate_holdout_s", (DL_FUNC) &_labyrinth_evaluate_holdout_s, 10},
+    {"_labyrinth_evaluate_holdout_d", (DL_FUNC) &_labyrinth_evaluate_holdout_d, 9},
+    {"_labyrinth_evaluate_holdout_m", (DL_FUNC) &_labyrinth_evaluate_holdout_m, 9},
     {"_labyrinth_get_neighbors_s", (DL_FUNC) &_labyrinth_get_neighbors_s, 3},
     {"_labyrinth_get_neighbors_d", (DL_FUNC) &_labyrinth_get_neighbors_d, 3},
-    {"_labyrinth_mrwr_", (DL_FUNC) &_labyrinth_mrwr_, 6},
-    {"_labyrinth_mrwr_s", (DL_FUNC) &_labyrinth_mrwr_s, 6},
+    {"_labyrinth_k_hop_neighbors_s", (DL_FUNC) &_labyrinth_k_hop_neighbors_s, 6},
+    {"_labyrinth_k_hop_neighbors_d", (DL_FUNC) &_labyrinth_k_hop_neighbors_d, 6},
+    {"_labyrinth_k_hop_neighbors_m", (DL_FUNC) &_labyrinth_k_hop_neighbors_m, 6},
+    {"_labyrinth_seed_ball_s", (DL_FUNC) &_labyrinth_seed_ball_s, 7},
+    {"_labyrinth_seed_ball_d", (DL_FUNC) &_labyrinth_seed_ball_d, 7},
+    {"_labyrinth_seed_ball_m", (DL_FUNC) &_labyrinth_seed_ball_m, 7},
+    {"_labyrinth_neighbor_lists_s", (DL_FUNC) &_labyrinth_neighbor_lists_s, 2},
+    {"_labyrinth_neighbor_lists_d", (DL_FUNC) &_labyrinth_neighbor_lists_d, 2},
+    {"_labyrinth_neighbor_lists_m", (DL_FUNC) &_labyrinth_neighbor_lists_m, 2},
+    {"_labyrinth_seed_ball_n", (DL_FUNC) &_labyrinth_seed_ball_n, 5},
+    {"_labyrinth_induced_subgraph_m", (DL_FUNC) &_labyrinth_induced_subgraph_m, 2},
+    {"_labyrinth_graph_order_s", (DL_FUNC) &_labyrinth_graph_order_s, 3},
+    {"_labyrinth_graph_order_d", (DL_FUNC) &_labyrinth_graph_order_d, 3},
+    {"_labyrinth_write_graph_store_", (DL_FUNC) &_labyrinth_write_graph_store_, 3},
+    {"_labyrinth_open_graph_store_", (DL_FUNC) &_labyrinth_open_graph_store_, 1},
+    {"_labyrinth_graph_store_links_", (DL_FUNC) &_labyrinth_graph_store_links_, 2},
+    {"_labyrinth_job_status_", (DL_FUNC) &_labyrinth_job_status_, 1},
+    {"_labyrinth_job_cancel_", (DL_FUNC) &_labyrinth_job_cancel_, 1},
+    {"_labyrinth_job_result_", (DL_FUNC) &_labyrinth_job_result_, 2},
+    {"_labyrinth_job_partial_", (DL_FUNC) &_labyrinth_job_partial_, 2},
+    {"_labyrinth_shared_segment_fail_", (DL_FUNC) &_labyrinth_shared_segment_fail_, 1},
+    {"_labyrinth_shared_segment_watch_", (DL_FUNC) &_labyrinth_shared_segment_watch_, 2},
+    {"_labyrinth_mrwr_", (DL_FUNC) &_labyrinth_mrwr_, 8},
+    {"_labyrinth_mrwr_s", (DL_FUNC) &_labyrinth_mrwr_s, 8},
+    {"_labyrinth_ppr_push_", (DL_FUNC) &_labyrinth_ppr_push_, 5},
+    {"_labyrinth_ppr_push_s", (DL_FUNC) &_labyrinth_ppr_push_s, 5},
+    {"_labyrinth_mrwr_m", (DL_FUNC) &_labyrinth_mrwr_m, 8},
+    {"_labyrinth_ppr_push_m", (DL_FUNC) &_labyrinth_ppr_push_m, 5},
+    {"_labyrinth_walk_segment_s", (DL_FUNC) &_labyrinth_walk_segment_s, 3},
+    {"_labyrinth_walk_segment_m", (DL_FUNC) &_labyrinth_walk_segment_m, 3},
+    {"_labyrinth_walk_partition_s", (DL_FUNC) &_labyrinth_walk_partition_s, 9},
+    {"_labyrinth_walk_partition_m", (DL_FUNC) &_labyrinth_walk_partition_m, 9},
+    {"_labyrinth_transpose_transition_", (DL_FUNC) &_labyrinth_transpose_transition_, 1},
+    {"_labyrinth_float_transition_s", (DL_FUNC) &_labyrinth_float_transition_s, 1},
+    {"_labyrinth_float_transition_d", (DL_FUNC) &_labyrinth_float_transition_d, 1},
+    {"_labyrinth_float_transition_m", (DL_FUNC) &_labyrinth_float_transition_m, 1},
+    {"_labyrinth_mrwr_f", (DL_FUNC) &_labyrinth_mrwr_f, 7},
+    {"_labyrinth_hash_columns_", (DL_FUNC) &_labyrinth_hash_columns_, 1},
+    {"_labyrinth_hash_graph_d", (DL_FUNC) &_labyrinth_hash_graph_d, 1},
+    {"_labyrinth_hash_graph_s", (DL_FUNC) &_labyrinth_hash_graph_s, 1},
+    {"_labyrinth_hash_strings_", (DL_FUNC) &_labyrinth_hash_strings_, 1},
+    {"_labyrinth_sigmoid_sum_", (DL_FUNC) &_labyrinth_sigmoid_sum_, 4},
     {"_labyrinth_transfer_activation_s", (DL_FUNC) &_labyrinth_transfer_activation_s, 5},
     {"_labyrinth_transfer_activation_d", (DL_FUNC) &_labyrinth_transfer_activation_d, 5},
-    {"_labyrinth_activation_rate_s", (DL_FUNC) &_labyrinth_activation_rate_s, 7},
-    {"_labyrinth_activation_rate_d", (DL_FUNC) &_labyrinth_activation_rate_d, 7},
+    {"_labyrinth_activation_rate_s", (DL_FUNC) &_labyrinth_activation_rate_s, 14},
+    {"_labyrinth_activation_rate_d", (DL_FUNC) &_labyrinth_activation_rate_d, 14},
+    {"_labyrinth_activation_rate_m", (DL_FUNC) &_labyrinth_activation_rate_m, 14},
+    {"_labyrinth_activation_rate_problem_s", (DL_FUNC) &_labyrinth_activation_rate_problem_s, 6},
+    {"_labyrinth_activation_rate_problem_d", (DL_FUNC) &_labyrinth_activation_rate_problem_d, 6},
+    {"_labyrinth_activation_rate_problem_m", (DL_FUNC) &_labyrinth_activation_rate_problem_m, 6},
+    {"_labyrinth_activation_rate_segment_", (DL_FUNC) &_labyrinth_activation_rate_segment_, 2},
+    {"_labyrinth_activation_rate_partition_", (DL_FUNC) &_labyrinth_activation_rate_partition_, 7},
     {"_labyrinth_sigmoid_t", (DL_FUNC) &_labyrinth_sigmoid_t, 3},
     {"_labyrinth_spread_gram_s", (DL_FUNC) &_labyrinth_spread_gram_s, 5},
     {"_labyrinth_spread_gram_d", (DL_FUNC) &_labyrinth_spread_gram_d, 5},
-    {"_labyrinth_gradient_s", (DL_FUNC) &_labyrinth_gradient_s, 4},
-    {"_labyrinth_gradient_d", (DL_FUNC) &_labyrinth_gradient_d, 4},
+    {"_labyrinth_gradient_s", (DL_FUNC) &_labyrinth_gradient_s, 5},
+    {"_labyrinth_gradient_d", (DL_FUNC) &_labyrinth_gradient_d, 5},
+    {"_labyrinth_spread_gram_iter_s", (DL_FUNC) &_labyrinth_spread_gram_iter_s, 10},
+    {"_labyrinth_spread_gram_iter_d", (DL_FUNC) &_labyrinth_spread_gram_iter_d, 10},
+    {"_labyrinth_spread_gram_iter_m", (DL_FUNC) &_labyrinth_spread_gram_iter_m, 10},
+    {"_labyrinth_spread_gram_problem_s", (DL_FUNC) &_labyrinth_spread_gram_problem_s, 4},
+    {"_labyrinth_spread_gram_problem_d", (DL_FUNC) &_labyrinth_spread_gram_problem_d, 4},
+    {"_labyrinth_spread_gram_problem_m", (DL_FUNC) &_labyrinth_spread_gram_problem_m, 4},
+    {"_labyrinth_spread_gram_segment_", (DL_FUNC) &_labyrinth_spread_gram_segment_, 2},
+    {"_labyrinth_spread_gram_partition_", (DL_FUNC) &_labyrinth_spread_gram_partition_, 7},
+    {"_labyrinth_erdos_renyi_", (DL_FUNC) &_labyrinth_erdos_renyi_, 3},
+    {"_labyrinth_barabasi_albert_", (DL_FUNC) &_labyrinth_barabasi_albert_, 3},
+    {"_labyrinth_bipartite_graph_", (DL_FUNC) &_labyrinth_bipartite_graph_, 5},
+    {"_labyrinth_thread_options_", (DL_FUNC) &_labyrinth_thread_options_, 2},
+    {"_labyrinth_top_k_", (DL_FUNC) &_labyrinth_top_k_, 3},
     {NULL, NULL, 0}
 };
 
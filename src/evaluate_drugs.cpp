@@ -0,0 +1,329 @@
+#include "../inst/include/labyrinth.h"
+
+// Leave-one-out evaluation of the random walk with restart, see
+// evaluate_drugs() in R. Every held-out query walks from one disease with the
+// links between the disease and its known drugs hidden, and the known drugs
+// are then scored among all drugs by ROC-AUC and average precision.
+//
+// Hiding the links of a query only changes the columns of W of the disease
+// and of its known drugs: the hidden entries drop out and the rest of each
+// column is scaled back to its sum. Every query keeps these changes as a few
+// deltas to W, added after the product with the shared W, so no query copies
+// the graph. Queries are walked in blocks of QUERY_BLOCK that share every
+// read of W, one block per thread, and every column stops on its own as in
+// mrwr_iterate().
+
+const Index QUERY_BLOCK = 16;
+
+// A change of one entry of W for a held-out query
+struct HoldoutDelta {
+    Index row, col;
+    double value;
+};
+
+// A held-out query: the seed (the node of the disease), the known drugs as
+// sorted node ids, and the deltas of W with their links hidden
+struct HoldoutQuery {
+    Index seed;
+    vector<Index> known;
+    vector<HoldoutDelta> deltas;
+};
+
+// The drugs linked to the seed in either direction
+template <typename T>
+vector<Index> holdout_links(const T &W, const Index &seed, const Index &drug_num) {
+    vector<Index> known;
+    for (Index drug = 0; drug < drug_num; drug++) {
+        if (W.coeff(drug, seed) != 0.0 || W.coeff(seed, drug) != 0.0) {
+            known.push_back(drug);
+        }
+    }
+    return(known);
+}
+
+// The deltas of the columns of W touched by hiding the links of the query.
+// A column left without edges is dropped, which leaks its mass as a dangling
+// node does
+template <typename T>
+void holdout_deltas(const T &W, HoldoutQuery &query) {
+    auto hidden = [&query](const Index &row, const Index &col) {
+        if (col == query.seed) {
+            return(std::binary_search(query.known.begin(), query.known.end(), row));
+        }
+        return(row == query.seed);
+    };
+
+    vector<Index> columns(query.known);
+    columns.push_back(query.seed);
+    for (Index col : columns) {
+        double sum = 0.0, kept = 0.0;
+        for_each_out_edge(W, col, [&](const Index &row, const double &weight) {
+            sum += weight;
+            if (!hidden(row, col)) {
+                kept += weight;
+            }
+        });
+        if (kept == sum) {
+            continue;
+        }
+        double scale = (kept > 1e-12 * sum) ? sum / kept : 0.0;
+        for_each_out_edge(W, col, [&](const Index &row, const double &weight) {
+            double value = hidden(row, col) ? -weight : (scale - 1.0) * weight;
+            if (value != 0.0) {
+                query.deltas.push_back({row, col, value});
+            }
+        });
+    }
+}
+
+// next = W * current on one thread, reading the rows of W in place: every
+// parallel block of queries runs its own product
+inline void holdout_product(const MSpMatR &W, const RowArrayXXd &current, RowArrayXXd &next) {
+    for (Index i = 0; i < W.outerSize(); i++) {
+        next.row(i).setZero();
+        for (MSpMatR::InnerIterator it(W, i); it; ++it) {
+            next.row(i) += it.value() * current.row(it.index());
+        }
+    }
+}
+
+inline void holdout_product(const MMatrixXd &W, const RowArrayXXd &current, RowArrayXXd &next) {
+    next.matrix().noalias() = W * current.matrix();
+}
+
+// ROC-AUC by the rank sum of the known drugs (Mann-Whitney U), and average
+// precision by the step-wise area under the precision-recall curve, as in
+// scikit-learn. Tied scores share their ranks and their precision, so the
+// order of the drugs does not matter. NA without known or unknown drugs
+pair<double, double> holdout_metrics(const VectorXd &scores, const vector<Index> &known) {
+    Index drugs = scores.size(), positives = known.size(), negatives = drugs - positives;
+    if (positives == 0 || negatives == 0) {
+        return(make_pair(NA_REAL, NA_REAL));
+    }
+    vector<bool> positive(drugs, false);
+    for (Index drug : known) {
+        positive[drug] = true;
+    }
+    vector<Index> ranking(drugs);
+    std::iota(ranking.begin(), ranking.end(), 0);
+    std::sort(ranking.begin(), ranking.end(), [&scores](const Index &a, const Index &b) {
+        return(scores[a] > scores[b]);
+    });
+
+    // Walk the tie groups from the highest score down
+    double rank_sum = 0.0, precision_sum = 0.0;
+    Index seen = 0, hits = 0;
+    for (Index first = 0; first < drugs;) {
+        Index last = first, group_hits = 0;
+        while (last < drugs && scores[ranking[last]] == scores[ranking[first]]) {
+            group_hits += positive[ranking[last]];
+            last++;
+        }
+        seen = last;
+        hits += group_hits;
+        // Ascending ranks of the group, averaged
+        double mean_rank = drugs - (first + last - 1) / 2.0;
+        rank_sum += group_hits * mean_rank;
+        precision_sum += group_hits * double(hits) / double(seen);
+        first = last;
+    }
+    double auc = (rank_sum - positives * (positives + 1) / 2.0) / (double(positives) * double(negatives));
+    return(make_pair(auc, precision_sum / positives));
+}
+
+template <typename T, typename P>
+List evaluate_holdout_t(const T &W, const P &W_product, const int &drug_num, const IntegerVector &diseases, const Nullable<List> &known, const double &r, const double &thresh, const int &niter, int threads, bool display_progress) {
+    const Index n = W.rows(), queries = diseases.size();
+    if (drug_num < 1 || drug_num >= n) {
+        stop("The model must hold drugs and diseases.");
+    }
+    vector<HoldoutQuery> held(queries);
+    for (Index q = 0; q < queries; q++) {
+        if (diseases[q] <= drug_num || diseases[q] > n) {
+            stop("The held-out diseases must be nodes of diseases.");
+        }
+        held[q].seed = diseases[q] - 1;
+    }
+    if (known.isNotNull()) {
+        List drugs(known.get());
+        if (drugs.size() != queries) {
+            stop("The known drugs must be given for every disease.");
+        }
+        for (Index q = 0; q < queries; q++) {
+            IntegerVector ids = drugs[q];
+            for (int id : ids) {
+                if (id < 1 || id > drug_num) {
+                    stop("The known drugs must be nodes of drugs.");
+                }
+                held[q].known.push_back(id - 1);
+            }
+            std::sort(held[q].known.begin(), held[q].known.end());
+            held[q].known.erase(std::unique(held[q].known.begin(), held[q].known.end()), held[q].known.end());
+        }
+    }
+
+    VectorXd auc = VectorXd::Constant(queries, NA_REAL), auprc = auc, residual = auc;
+    VectorXi positives = VectorXi::Zero(queries), iterations = positives;
+
+    ThreadScope scope(threads);
+    KernelMonitor monitor(queries, display_progress);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (Index first = 0; first < queries; first += QUERY_BLOCK) {
+        if (monitor.aborted()) {
+            continue;
+        }
+        Index width = std::min(QUERY_BLOCK, queries - first);
+        for (Index q = first; q < first + width; q++) {
+            if (!known.isNotNull()) {
+                held[q].known = holdout_links(W, held[q].seed, drug_num);
+            }
+            holdout_deltas(W, held[q]);
+        }
+
+        // The queries of the block still walking, as columns of the block
+        vector<Index> active;
+        for (Index q = first; q < first + width; q++) {
+            if (!held[q].known.empty()) {
+                active.push_back(q);
+            }
+        }
+        RowArrayXXd current = RowArrayXXd::Zero(n, active.size()), next(n, active.size());
+        for (size_t i = 0; i < active.size(); i++) {
+            current(held[active[i]].seed, i) = 1.0;
+        }
+
+        int iter = 0;
+        auto finish = [&](const Index &q, const RowArrayXXd &walked, const Index &column) {
+            VectorXd scores = walked.col(column).head(drug_num).matrix();
+            pair<double, double> metrics = holdout_metrics(scores, held[q].known);
+            auc[q] = metrics.first;
+            auprc[q] = metrics.second;
+        };
+        while (!active.empty() && iter < niter && !monitor.aborted()) {
+            holdout_product(W_product, current, next);
+            for (size_t i = 0; i < active.size(); i++) {
+                for (const HoldoutDelta &delta : held[active[i]].deltas) {
+                    next(delta.row, i) += delta.value * current(delta.col, i);
+                }
+            }
+            next *= 1.0 - r;
+            for (size_t i = 0; i < active.size(); i++) {
+                next(held[active[i]].seed, i) += r;
+            }
+            iter++;
+
+            ArrayXd step = (next - current).abs().colwise().sum().transpose();
+            vector<Index> kept;
+            for (size_t i = 0; i < active.size(); i++) {
+                iterations[active[i]] = iter;
+                residual[active[i]] = step[i];
+                if (step[i] < thresh) {
+                    finish(active[i], next, i);
+                } else {
+                    kept.push_back(i);
+                }
+            }
+
+            // Drop converged columns
+            if (kept.size() < active.size()) {
+                RowArrayXXd compacted(n, kept.size());
+                vector<Index> kept_queries;
+                for (size_t i = 0; i < kept.size(); i++) {
+                    compacted.col(i) = next.col(kept[i]);
+                    kept_queries.push_back(active[kept[i]]);
+                }
+                next.swap(compacted);
+                active.swap(kept_queries);
+                current.resize(n, active.size());
+            }
+            current.swap(next);
+        }
+
+        // Columns that never converge
+        for (size_t i = 0; i < active.size(); i++) {
+            finish(active[i], current, i);
+        }
+        for (Index q = first; q < first + width; q++) {
+            positives[q] = held[q].known.size();
+            held[q].deltas = vector<HoldoutDelta>();
+        }
+        monitor.increment(width);
+    }
+
+    if (monitor.aborted()) {
+        stop("The evaluation was interrupted.");
+    }
+    return(List::create(Named("auc") = auc,
+                        Named("auprc") = auprc,
+                        Named("positives") = positives,
+                        Named("iterations") = iterations,
+                        Named("residual") = residual));
+}
+
+//' Evaluate the random walk with restart by held-out queries.
+//'
+//' @noRd
+//' @param W  the column normalized adjacency matrix of the model
+//' @param W_t  its transpose, from transpose_transition_(), whose columns are
+//'   read as the rows of W
+//' @param drug_num  the drugs, which are the first nodes of the model
+//' @param diseases  the (1-based) nodes of the held-out diseases
+//' @param known  NULL to take the drugs linked to every disease, or a list
+//'   with the (1-based) nodes of the known drugs of every disease
+//' @param r  restart probability
+//' @param thresh  threshold to break as soon as new stationary distribution
+//'   converges to the stationary distribution of the previous timepoint
+//' @param niter  maximum number of iterations for the chain
+//' @param threads  the parallel threads, 0 for the default
+//' @param display_progress  boolean if the progress bar is shown
+//' @return  returns a list with the ROC-AUC, the average precision, the known
+//'   drugs, the iterations and the last L1 step of every held-out disease
+// [[Rcpp::export]]
+List evaluate_holdout_s(const MSpMat &W, const MSpMat &W_t, const int drug_num, const IntegerVector &diseases, Nullable<List> known = R_NilValue, const double r = 0.7, const double thresh = 1e-6, const int niter = 1000000, int threads = 0, bool display_progress = false) {
+    return(evaluate_holdout_t(W, transition_rows(W_t), drug_num, diseases, known, r, thresh, niter, threads, display_progress));
+}
+
+//' Evaluate the random walk with restart by held-out queries.
+//'
+//' @noRd
+//' @param W  the column normalized adjacency matrix of the model
+//' @param drug_num  the drugs, which are the first nodes of the model
+//' @param diseases  the (1-based) nodes of the held-out diseases
+//' @param known  NULL to take the drugs linked to every disease, or a list
+//'   with the (1-based) nodes of the known drugs of every disease
+//' @param r  restart probability
+//' @param thresh  threshold to break as soon as new stationary distribution
+//'   converges to the stationary distribution of the previous timepoint
+//' @param niter  maximum number of iterations for the chain
+//' @param threads  the parallel threads, 0 for the default
+//' @param display_progress  boolean if the progress bar is shown
+//' @return  returns a list with the ROC-AUC, the average precision, the known
+//'   drugs, the iterations and the last L1 step of every held-out disease
+// [[Rcpp::export]]
+List evaluate_holdout_d(const MMatrixXd &W, const int drug_num, const IntegerVector &diseases, Nullable<List> known = R_NilValue, const double r = 0.7, const double thresh = 1e-6, const int niter = 1000000, int threads = 0, bool display_progress = false) {
+    return(evaluate_holdout_t(W, W, drug_num, diseases, known, r, thresh, niter, threads, display_progress));
+}
+
+//' Evaluate the random walk with restart by held-out queries, on the
+//' transition matrix of a graph store.
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store with a transition matrix
+//' @param drug_num  the drugs, which are the first nodes of the model
+//' @param diseases  the (1-based) nodes of the held-out diseases
+//' @param known  NULL to take the drugs linked to every disease, or a list
+//'   with the (1-based) nodes of the known drugs of every disease
+//' @param r  restart probability
+//' @param thresh  threshold to break as soon as new stationary distribution
+//'   converges to the stationary distribution of the previous timepoint
+//' @param niter  maximum number of iterations for the chain
+//' @param threads  the parallel threads, 0 for the default
+//' @param display_progress  boolean if the progress bar is shown
+//' @return  returns a list with the ROC-AUC, the average precision, the known
+//'   drugs, the iterations and the last L1 step of every held-out disease
+// [[Rcpp::export]]
+List evaluate_holdout_m(SEXP store, const int drug_num, const IntegerVector &diseases, Nullable<List> known = R_NilValue, const double r = 0.7, const double thresh = 1e-6, const int niter = 1000000, int threads = 0, bool display_progress = false) {
+    const MSpMat W = graph_store_matrix(store, 1);
+    return(evaluate_holdout_t(W, transition_rows(graph_store_matrix(store, 2)), drug_num, diseases, known, r, thresh, niter, threads, display_progress));
+}
@@ -27,6 +27,100 @@ ArrayXi get_neighbors_t(const T &adj_matrix, const int &node_id, const int &neig
     return(ret_neighbors);
 }
 
+// get_neighbors_t is used by other translation units as well
+template ArrayXi get_neighbors_t<MSpMat>(const MSpMat &adj_matrix, const int &node_id, const int &neighbor_type);
+template ArrayXi get_neighbors_t<MMatrixXd>(const MMatrixXd &adj_matrix, const int &node_id, const int &neighbor_type);
+
+// Visit all non-zero off-diagonal cells (row, col) of the adjacency matrix
+template <typename F>
+void for_each_edge(const MSpMat &adj_matrix, F visit) {
+    for (Index col = 0; col < adj_matrix.outerSize(); col++) {
+        for (MSpMat::InnerIterator it(adj_matrix, col); it; ++it) {
+            if (it.value() != 0 && it.row() != col) {
+                visit(it.row(), col);
+            }
+        }
+    }
+}
+
+template <typename F>
+void for_each_edge(const MMatrixXd &adj_matrix, F visit) {
+    for (Index col = 0; col < adj_matrix.cols(); col++) {
+        for (Index row = 0; row < adj_matrix.rows(); row++) {
+            if (adj_matrix(row, col) != 0 && row != col) {
+                visit(row, col);
+            }
+        }
+    }
+}
+
+template <typename T>
+NeighborList build_neighbors_t(const T &adj_matrix) {
+    NeighborList neighbors;
+    size_t n = adj_matrix.rows();
+    neighbors.n = n;
+
+    // Count both ends of each edge, then scatter them into per-node slots
+    vector<size_t> slots(n + 1, 0);
+    for_each_edge(adj_matrix, [&](Index row, Index col) {
+        slots[row + 1]++;
+        slots[col + 1]++;
+    });
+    std::partial_sum(slots.begin(), slots.end(), slots.begin());
+
+    vector<pair<int, unsigned char>> entries(slots[n]);
+    vector<size_t> fill(slots.begin(), slots.end() - 1);
+    for_each_edge(adj_matrix, [&](Index row, Index col) {
+        // row -> col: col is downstream of row, row is upstream of col
+        entries[fill[row]++] = make_pair(int(col), NEIGHBOR_FORWARD);
+        entries[fill[col]++] = make_pair(int(row), NEIGHBOR_BACKWARD);
+    });
+    fill.clear();
+
+    // Sort each node's slots and merge reciprocal edges
+    vector<size_t> degree(n + 1, 0);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t node = 0; node < n; node++) {
+        auto first = entries.begin() + slots[node];
+        auto last = entries.begin() + slots[node + 1];
+        if (first == last) {
+            continue;
+        }
+        std::sort(first, last);
+        auto merged = first;
+        for (auto it = first + 1; it != last; ++it) {
+            if (it->first == merged->first) {
+                merged->second |= it->second;
+            } else {
+                *(++merged) = *it;
+            }
+        }
+        degree[node + 1] = merged - first + 1;
+    }
+
+    neighbors.outer.resize(n + 1);
+    std::partial_sum(degree.begin(), degree.end(), neighbors.outer.begin());
+    neighbors.inner.resize(neighbors.outer[n]);
+    neighbors.direction.resize(neighbors.outer[n]);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t node = 0; node < n; node++) {
+        size_t from = slots[node], to = neighbors.outer[node];
+        for (size_t k = 0; k < neighbors.degree(node); k++) {
+            neighbors.inner[to + k] = entries[from + k].first;
+            neighbors.direction[to + k] = entries[from + k].second;
+        }
+    }
+    return(neighbors);
+}
+
+NeighborList build_neighbors(const MSpMat &adj_matrix) {
+    return(build_neighbors_t(adj_matrix));
+}
+
+NeighborList build_neighbors(const MMatrixXd &adj_matrix) {
+    return(build_neighbors_t(adj_matrix));
+}
+
 // TODO: mention overloading, help needed
 //' Get neighboring nodes in a graph (adjacency matrix)
 //'
@@ -117,3 +211,414 @@ ArrayXi get_neighbors_s(const MSpMat &adj_matrix, const int &node_id, const int
 ArrayXi get_neighbors_d(const MMatrixXd &adj_matrix, const int &node_id, const int neighbor_type) {
     return(get_neighbors_t(adj_matrix, node_id, neighbor_type));
 }
+
+// The k-hop neighborhoods of many seeds, by a breadth-first search over the
+// neighbor lists for every seed in parallel. A thread marks the nodes it has
+// seen with the index of its current seed, so the marks are never cleared.
+// Every hop is sorted, so the neighbors of a seed come by distance, then by
+// id. `hops` < 0 searches the whole reachable component
+List k_hop_neighbors_t(const NeighborList &neighbors, const IntegerVector &nodes, const int &hops, const int &neighbor_type, const bool &with_distance) {
+    const unsigned char mask = (neighbor_type == 1) ? NEIGHBOR_FORWARD : (neighbor_type == 2) ? NEIGHBOR_BACKWARD : NEIGHBOR_BOTH;
+    const vector<int> seeds(nodes.begin(), nodes.end());
+    const size_t n = neighbors.n;
+    for (int seed : seeds) {
+        if (seed < 0 || size_t(seed) >= n) {
+            stop("The node ids must be between 1 and the number of nodes.");
+        }
+    }
+    vector<vector<int>> found(seeds.size()), distance(seeds.size());
+
+    #pragma omp parallel
+    {
+        vector<int> seen(n, -1), frontier, next;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t s = 0; s < seeds.size(); s++) {
+            frontier.assign(1, seeds[s]);
+            seen[seeds[s]] = int(s);
+            for (int hop = 1; !frontier.empty() && (hops < 0 || hop <= hops); hop++) {
+                next.clear();
+                for (int u : frontier) {
+                    for (size_t k = neighbors.outer[u]; k < neighbors.outer[u + 1]; k++) {
+                        int v = neighbors.inner[k];
+                        if ((neighbors.direction[k] & mask) && seen[v] != int(s)) {
+                            seen[v] = int(s);
+                            next.push_back(v);
+                        }
+                    }
+                }
+                std::sort(next.begin(), next.end());
+                found[s].insert(found[s].end(), next.begin(), next.end());
+                if (with_distance) {
+                    distance[s].resize(found[s].size(), hop);
+                }
+                frontier.swap(next);
+            }
+        }
+    }
+
+    IntegerVector offsets(seeds.size() + 1);
+    size_t total = 0;
+    for (size_t s = 0; s < seeds.size(); s++) {
+        total += found[s].size();
+        if (total > size_t(std::numeric_limits<int>::max())) {
+            stop("The neighborhoods have more than 2^31 - 1 nodes in total.");
+        }
+        offsets[s + 1] = int(total);
+    }
+    IntegerVector ids(total), hop_distance(with_distance ? total : 0);
+    for (size_t s = 0; s < seeds.size(); s++) {
+        for (size_t i = 0; i < found[s].size(); i++) {
+            ids[offsets[s] + i] = found[s][i] + 1;
+            if (with_distance) {
+                hop_distance[offsets[s] + i] = distance[s][i];
+            }
+        }
+    }
+    List ret = List::create(Named("offsets") = offsets, Named("ids") = ids);
+    if (with_distance) {
+        ret["distance"] = hop_distance;
+    }
+    return(ret);
+}
+
+template <typename T>
+List k_hop_neighbors_t(const T &adj_matrix, const IntegerVector &nodes, const int &hops, const int &neighbor_type, const bool &with_distance, const int &threads) {
+    ThreadScope scope(threads);
+    return(k_hop_neighbors_t(build_neighbors(adj_matrix), nodes, hops, neighbor_type, with_distance));
+}
+
+//' Get the k-hop neighborhoods of many nodes.
+//'
+//' @noRd
+//' @param adj_matrix  the adjacency matrix
+//' @param nodes  the (0-based) ids of the nodes
+//' @param hops  the hops of the neighborhoods, or negative for all reachable
+//'   nodes
+//' @param neighbor_type  0 for both, 1 for forward or 2 for backward
+//'   neighbors, see get_neighbors_s()
+//' @param distance  boolean if the hops of every neighbor are returned
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list of the (0-based) offsets of the neighborhood of
+//'   every node, the (1-based) ids of the neighbors, and their distances
+// [[Rcpp::export]]
+List k_hop_neighbors_s(const MSpMat &adj_matrix, const IntegerVector &nodes, const int hops = 1, const int neighbor_type = 0, const bool distance = false, const int threads = 0) {
+    return(k_hop_neighbors_t(adj_matrix, nodes, hops, neighbor_type, distance, threads));
+}
+
+//' Get the k-hop neighborhoods of many nodes.
+//'
+//' @noRd
+//' @param adj_matrix  the adjacency matrix
+//' @param nodes  the (0-based) ids of the nodes
+//' @param hops  the hops of the neighborhoods, or negative for all reachable
+//'   nodes
+//' @param neighbor_type  0 for both, 1 for forward or 2 for backward
+//'   neighbors, see get_neighbors_s()
+//' @param distance  boolean if the hops of every neighbor are returned
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list of the (0-based) offsets of the neighborhood of
+//'   every node, the (1-based) ids of the neighbors, and their distances
+// [[Rcpp::export]]
+List k_hop_neighbors_d(const MMatrixXd &adj_matrix, const IntegerVector &nodes, const int hops = 1, const int neighbor_type = 0, const bool distance = false, const int threads = 0) {
+    return(k_hop_neighbors_t(adj_matrix, nodes, hops, neighbor_type, distance, threads));
+}
+
+//' Get the k-hop neighborhoods of many nodes.
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store
+//' @param nodes  the (0-based) ids of the nodes
+//' @param hops  the hops of the neighborhoods, or negative for all reachable
+//'   nodes
+//' @param neighbor_type  0 for both, 1 for forward or 2 for backward
+//'   neighbors, see get_neighbors_s()
+//' @param distance  boolean if the hops of every neighbor are returned
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list of the (0-based) offsets of the neighborhood of
+//'   every node, the (1-based) ids of the neighbors, and their distances
+// [[Rcpp::export]]
+List k_hop_neighbors_m(SEXP store, const IntegerVector &nodes, const int hops = 1, const int neighbor_type = 0, const bool distance = false, const int threads = 0) {
+    const MSpMat adj_matrix = graph_store_matrix(store, 0);
+    return(k_hop_neighbors_t(adj_matrix, nodes, hops, neighbor_type, distance, threads));
+}
+
+// The ball of a seed-local propagation around the seeds, the nonzero rows of
+// `p0`. The seeds of each query weigh 1 in total, and a node carries the
+// largest weight any query gives it. The ball grows hop by hop: every node u
+// of the last hop passes `decay` of its mass to the next hop, and
+// `for_each_share(u, pass)` calls pass(v, share) for the share of it that
+// each neighbor v receives. A node joins if it receives at least `epsilon`.
+// It stops after `hops` hops (< 0 for no limit) or when no node joins. The
+// mass passed to the nodes left out is the leak, which estimates the mass of
+// the propagation outside the ball. It is no bound: the propagation passes
+// the mass of the ball on again, which the ball only passes once
+template <typename Shares>
+List seed_ball_t(const size_t &n, Shares for_each_share, const MMatrixXd &p0, const int &hops, const double &epsilon, const double &decay) {
+    if (size_t(p0.rows()) != n) {
+        stop("The weights must have one row per node.");
+    }
+    vector<double> mass(n, 0.0), received(n, 0.0);
+    for (Index query = 0; query < p0.cols(); query++) {
+        double total = p0.col(query).sum();
+        if (total <= 0) {
+            continue;
+        }
+        for (size_t node = 0; node < n; node++) {
+            mass[node] = std::max(mass[node], p0(node, query) / total);
+        }
+    }
+
+    vector<unsigned char> inside(n, 0), touched(n, 0);
+    vector<int> ball, frontier, reached;
+    for (size_t node = 0; node < n; node++) {
+        if (mass[node] > 0) {
+            inside[node] = 1;
+            frontier.push_back(int(node));
+        }
+    }
+    ball = frontier;
+
+    double leak = 0;
+    int hop = 0;
+    for (; !frontier.empty() && (hops < 0 || hop < hops); hop++) {
+        reached.clear();
+        for (int u : frontier) {
+            double passed = decay * mass[u];
+            for_each_share(size_t(u), [&](const int &v, const double &share) {
+                if (inside[v]) {
+                    return;
+                }
+                if (!touched[v]) {
+                    touched[v] = 1;
+                    reached.push_back(v);
+                }
+                received[v] += passed * share;
+            });
+        }
+        frontier.clear();
+        for (int v : reached) {
+            if (received[v] >= epsilon) {
+                inside[v] = 1;
+                mass[v] = received[v];
+                frontier.push_back(v);
+            } else {
+                leak += received[v];
+            }
+            received[v] = 0;
+            touched[v] = 0;
+        }
+        ball.insert(ball.end(), frontier.begin(), frontier.end());
+    }
+    // The last hop of a ball limited by `hops` leaks what it would pass on
+    for (int u : frontier) {
+        double passed = decay * mass[u];
+        for_each_share(size_t(u), [&](const int &v, const double &share) {
+            if (!inside[v]) {
+                leak += passed * share;
+            }
+        });
+    }
+
+    std::sort(ball.begin(), ball.end());
+    IntegerVector nodes(ball.size());
+    for (size_t i = 0; i < ball.size(); i++) {
+        nodes[i] = ball[i] + 1;
+    }
+    return(List::create(Named("nodes") = nodes, Named("hops") = frontier.empty() ? hop - 1 : hop,
+                        Named("leak") = leak));
+}
+
+// The ball regarding the graph as undirected, whose nodes split their mass
+// evenly among their neighbors, as the spreading activation has no
+// transition matrix
+List seed_ball_t(const NeighborList &neighbors, const MMatrixXd &p0, const int &hops, const double &epsilon, const double &decay) {
+    auto shares = [&](const size_t &u, auto pass) {
+        double share = 1.0 / std::max(neighbors.degree(u), size_t(1));
+        for (size_t k = neighbors.outer[u]; k < neighbors.outer[u + 1]; k++) {
+            pass(neighbors.inner[k], share);
+        }
+    };
+    return(seed_ball_t(neighbors.n, shares, p0, hops, epsilon, decay));
+}
+
+// The ball of the random walk, whose nodes pass their mass along the columns
+// of the transition matrix W: v receives W(v, u) of the mass of u
+List seed_ball_t(const MSpMat &W, const MMatrixXd &p0, const int &hops, const double &epsilon, const double &decay) {
+    auto shares = [&](const size_t &u, auto pass) {
+        for (MSpMat::InnerIterator it(W, Index(u)); it; ++it) {
+            if (it.value() != 0 && size_t(it.row()) != u) {
+                pass(int(it.row()), it.value());
+            }
+        }
+    };
+    return(seed_ball_t(size_t(W.rows()), shares, p0, hops, epsilon, decay));
+}
+
+List seed_ball_t(const MMatrixXd &W, const MMatrixXd &p0, const int &hops, const double &epsilon, const double &decay) {
+    auto shares = [&](const size_t &u, auto pass) {
+        for (Index v = 0; v < W.rows(); v++) {
+            if (W(v, u) != 0 && size_t(v) != u) {
+                pass(int(v), W(v, u));
+            }
+        }
+    };
+    return(seed_ball_t(size_t(W.rows()), shares, p0, hops, epsilon, decay));
+}
+
+// The ball of the graph `matrix`, or of the transition matrix if `transition`
+template <typename T>
+List seed_ball_t(const T &matrix, const MMatrixXd &p0, const int &hops, const double &epsilon, const double &decay, const bool &transition, const int &threads) {
+    ThreadScope scope(threads);
+    if (transition) {
+        return(seed_ball_t(matrix, p0, hops, epsilon, decay));
+    }
+    return(seed_ball_t(build_neighbors(matrix), p0, hops, epsilon, decay));
+}
+
+//' Get the ball of a seed-local propagation.
+//'
+//' @noRd
+//' @param matrix  the adjacency matrix, or the transition matrix
+//' @param p0  the initial weights, one column per query
+//' @param hops  the largest hops from the seeds, or negative for no limit
+//' @param epsilon  the smallest mass of a node joining the ball
+//' @param decay  the fraction of its mass a hop passes to the next one
+//' @param transition  boolean if `matrix` is the transition matrix, whose
+//'   columns the mass is passed along, instead of the adjacency matrix
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list of the sorted (1-based) ids of the nodes in the
+//'   ball, the hops it spans, and the mass leaked out of it
+// [[Rcpp::export]]
+List seed_ball_s(const MSpMat &matrix, const MMatrixXd &p0, const int hops = -1, const double epsilon = 0, const double decay = 1, const bool transition = false, const int threads = 0) {
+    return(seed_ball_t(matrix, p0, hops, epsilon, decay, transition, threads));
+}
+
+//' Get the ball of a seed-local propagation.
+//'
+//' @noRd
+//' @param matrix  the adjacency matrix, or the transition matrix
+//' @param p0  the initial weights, one column per query
+//' @param hops  the largest hops from the seeds, or negative for no limit
+//' @param epsilon  the smallest mass of a node joining the ball
+//' @param decay  the fraction of its mass a hop passes to the next one
+//' @param transition  boolean if `matrix` is the transition matrix, whose
+//'   columns the mass is passed along, instead of the adjacency matrix
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list of the sorted (1-based) ids of the nodes in the
+//'   ball, the hops it spans, and the mass leaked out of it
+// [[Rcpp::export]]
+List seed_ball_d(const MMatrixXd &matrix, const MMatrixXd &p0, const int hops = -1, const double epsilon = 0, const double decay = 1, const bool transition = false, const int threads = 0) {
+    return(seed_ball_t(matrix, p0, hops, epsilon, decay, transition, threads));
+}
+
+//' Get the ball of a seed-local propagation.
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store
+//' @param p0  the initial weights, one column per query
+//' @param hops  the largest hops from the seeds, or negative for no limit
+//' @param epsilon  the smallest mass of a node joining the ball
+//' @param decay  the fraction of its mass a hop passes to the next one
+//' @param transition  boolean if the mass is passed along the columns of the
+//'   transition matrix of the store, instead of the edges of its graph
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list of the sorted (1-based) ids of the nodes in the
+//'   ball, the hops it spans, and the mass leaked out of it
+// [[Rcpp::export]]
+List seed_ball_m(SEXP store, const MMatrixXd &p0, const int hops = -1, const double epsilon = 0, const double decay = 1, const bool transition = false, const int threads = 0) {
+    const MSpMat matrix = graph_store_matrix(store, transition ? 1 : 0);
+    return(seed_ball_t(matrix, p0, hops, epsilon, decay, transition, threads));
+}
+
+// The neighbor lists of a model, built once by prepare_model() and kept
+// behind an external pointer for the balls of its queries
+SEXP neighbor_lists(NeighborList *neighbors) {
+    return(XPtr<NeighborList>(neighbors, true));
+}
+
+//' Build the neighbor lists of a graph.
+//'
+//' @noRd
+//' @param graph  the adjacency matrix
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns the external pointer of the neighbor lists
+// [[Rcpp::export]]
+SEXP neighbor_lists_s(const MSpMat &graph, const int threads = 0) {
+    ThreadScope scope(threads);
+    return(neighbor_lists(new NeighborList(build_neighbors(graph))));
+}
+
+//' Build the neighbor lists of a graph.
+//'
+//' @noRd
+//' @param graph  the adjacency matrix
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns the external pointer of the neighbor lists
+// [[Rcpp::export]]
+SEXP neighbor_lists_d(const MMatrixXd &graph, const int threads = 0) {
+    ThreadScope scope(threads);
+    return(neighbor_lists(new NeighborList(build_neighbors(graph))));
+}
+
+//' Build the neighbor lists of the graph of a graph store.
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns the external pointer of the neighbor lists
+// [[Rcpp::export]]
+SEXP neighbor_lists_m(SEXP store, const int threads = 0) {
+    const MSpMat graph = graph_store_matrix(store, 0);
+    ThreadScope scope(threads);
+    return(neighbor_lists(new NeighborList(build_neighbors(graph))));
+}
+
+//' Get the ball of a seed-local propagation from prepared neighbor lists.
+//'
+//' @noRd
+//' @param neighbors  the external pointer of the neighbor lists, see
+//'   neighbor_lists_s()
+//' @param p0  the initial weights, one column per query
+//' @param hops  the largest hops from the seeds, or negative for no limit
+//' @param epsilon  the smallest mass of a node joining the ball
+//' @param decay  the fraction of its mass a hop passes to the next one
+//' @return  returns a list of the sorted (1-based) ids of the nodes in the
+//'   ball, the hops it spans, and the mass leaked out of it
+// [[Rcpp::export]]
+List seed_ball_n(SEXP neighbors, const MMatrixXd &p0, const int hops = -1, const double epsilon = 0, const double decay = 1) {
+    XPtr<NeighborList> pointer(neighbors);
+    if (pointer.get() == nullptr) {
+        stop("The neighbor lists are gone. Prepare the model again with prepare_model().");
+    }
+    return(seed_ball_t(*pointer, p0, hops, epsilon, decay));
+}
+
+//' Get the subgraph of a graph store induced by some nodes.
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store
+//' @param nodes  the sorted (1-based) ids of the nodes
+//' @return  returns the subgraph as a dgCMatrix, whose node i is nodes[i]
+// [[Rcpp::export]]
+SpMat induced_subgraph_m(SEXP store, const IntegerVector &nodes) {
+    const MSpMat graph = graph_store_matrix(store, 0);
+    vector<int> position(graph.rows(), -1);
+    for (R_xlen_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i] < 1 || nodes[i] > graph.rows() || (i > 0 && nodes[i] <= nodes[i - 1])) {
+            stop("The node ids must be sorted, unique, and between 1 and the number of nodes.");
+        }
+        position[nodes[i] - 1] = int(i);
+    }
+    vector<Triplet<double>> edges;
+    for (R_xlen_t i = 0; i < nodes.size(); i++) {
+        for (MSpMat::InnerIterator it(graph, nodes[i] - 1); it; ++it) {
+            if (position[it.row()] >= 0) {
+                edges.emplace_back(position[it.row()], int(i), it.value());
+            }
+        }
+    }
+    SpMat subgraph(nodes.size(), nodes.size());
+    subgraph.setFromTriplets(edges.begin(), edges.end());
+    return(subgraph);
+}
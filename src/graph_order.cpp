@@ -0,0 +1,210 @@
+#include "../inst/include/labyrinth.h"
+
+// Orders of the nodes that keep neighbors close in memory, so that walking a
+// neighbor list reads nearby activation rates instead of random ones. All of
+// them regard the graph as undirected and are deterministic. order[i] is the
+// original id of the node placed at position i.
+
+// Reverse Cuthill-McKee: a breadth-first search from a node of minimum degree
+// in every component, visiting the neighbors by increasing degree, reversed.
+vector<int> rcm_order(const NeighborList &neighbors) {
+    size_t n = neighbors.n;
+    vector<int> order, by_degree(n);
+    vector<bool> visited(n, false);
+    order.reserve(n);
+    std::iota(by_degree.begin(), by_degree.end(), 0);
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&](const int &a, const int &b) {
+        return(neighbors.degree(a) < neighbors.degree(b));
+    });
+
+    vector<int> next;
+    for (int root : by_degree) {
+        if (visited[root]) {
+            continue;
+        }
+        visited[root] = true;
+        for (size_t head = order.size(), tail = (order.push_back(root), order.size()); head < tail; head++, tail = order.size()) {
+            int node = order[head];
+            next.clear();
+            for (size_t k = neighbors.outer[node]; k < neighbors.outer[node + 1]; k++) {
+                if (!visited[neighbors.inner[k]]) {
+                    visited[neighbors.inner[k]] = true;
+                    next.push_back(neighbors.inner[k]);
+                }
+            }
+            std::stable_sort(next.begin(), next.end(), [&](const int &a, const int &b) {
+                return(neighbors.degree(a) < neighbors.degree(b));
+            });
+            order.insert(order.end(), next.begin(), next.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return(order);
+}
+
+// Decreasing degree: the hubs, which are read by most neighbor lists, share
+// the first cache lines
+vector<int> degree_order(const NeighborList &neighbors) {
+    vector<int> order(neighbors.n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const int &a, const int &b) {
+        return(neighbors.degree(a) > neighbors.degree(b));
+    });
+    return(order);
+}
+
+// Communities found by label propagation are laid out one after another, the
+// largest first. Every node takes the most frequent label of its neighbors,
+// the smallest one on ties, in node order until no label changes.
+vector<int> community_order(const NeighborList &neighbors, const int max_iter = 20) {
+    size_t n = neighbors.n;
+    vector<int> label(n), count(n, 0), seen;
+    std::iota(label.begin(), label.end(), 0);
+
+    bool changed = true;
+    for (int iter = 0; iter < max_iter && changed; iter++) {
+        changed = false;
+        for (size_t node = 0; node < n; node++) {
+            int best = label[node], best_count = 0;
+            seen.clear();
+            for (size_t k = neighbors.outer[node]; k < neighbors.outer[node + 1]; k++) {
+                int candidate = label[neighbors.inner[k]];
+                if (count[candidate]++ == 0) {
+                    seen.push_back(candidate);
+                }
+            }
+            for (int candidate : seen) {
+                if (count[candidate] > best_count || (count[candidate] == best_count && candidate < best)) {
+                    best = candidate;
+                    best_count = count[candidate];
+                }
+                count[candidate] = 0;
+            }
+            if (best_count > 0 && best != label[node]) {
+                label[node] = best;
+                changed = true;
+            }
+        }
+    }
+
+    vector<int> size(n, 0), order(n);
+    for (size_t node = 0; node < n; node++) {
+        size[label[node]]++;
+    }
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const int &a, const int &b) {
+        if (label[a] == label[b]) {
+            return(false);
+        }
+        return(size[label[a]] > size[label[b]] || (size[label[a]] == size[label[b]] && label[a] < label[b]));
+    });
+    return(order);
+}
+
+vector<int> graph_order(const NeighborList &neighbors, const std::string &method, const bool fix_first) {
+    vector<int> order;
+    if (method == "rcm") {
+        order = rcm_order(neighbors);
+    } else if (method == "degree") {
+        order = degree_order(neighbors);
+    } else if (method == "community") {
+        order = community_order(neighbors);
+    } else {
+        stop("Unknown method: " + method);
+    }
+
+    // Keep the first node in front, e.g. for remove_first in activation_rate()
+    if (fix_first && !order.empty()) {
+        order.erase(std::find(order.begin(), order.end(), 0));
+        order.insert(order.begin(), 0);
+    }
+    return(order);
+}
+
+// The neighbor lists with node order[i] renamed to i. The neighbors of every
+// node stay sorted, and node_id keeps the original ids, which Spread-gram
+// needs for its sigmoid
+NeighborList permute_neighbors(const NeighborList &neighbors, const vector<int> &order) {
+    size_t n = neighbors.n;
+    vector<int> position(n);
+    for (size_t i = 0; i < n; i++) {
+        position[order[i]] = int(i);
+    }
+
+    NeighborList permuted;
+    permuted.n = n;
+    permuted.outer.resize(n + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        permuted.outer[i + 1] = permuted.outer[i] + neighbors.degree(order[i]);
+    }
+    permuted.inner.resize(neighbors.edges());
+    permuted.direction.resize(neighbors.edges());
+    permuted.node_id.resize(n);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t i = 0; i < n; i++) {
+        size_t node = order[i], first = neighbors.outer[node], degree = neighbors.degree(node);
+        vector<pair<int, unsigned char>> entries(degree);
+        for (size_t k = 0; k < degree; k++) {
+            entries[k] = make_pair(position[neighbors.inner[first + k]], neighbors.direction[first + k]);
+        }
+        std::sort(entries.begin(), entries.end());
+        for (size_t k = 0; k < degree; k++) {
+            permuted.inner[permuted.outer[i] + k] = entries[k].first;
+            permuted.direction[permuted.outer[i] + k] = entries[k].second;
+        }
+        permuted.node_id[i] = int(neighbors.original_id(node));
+    }
+    return(permuted);
+}
+
+// Node-indexed rows into the permuted order, and back
+MatrixXd permute_rows(const MatrixXd &x, const vector<int> &order) {
+    MatrixXd permuted(x.rows(), x.cols());
+    for (size_t i = 0; i < order.size(); i++) {
+        permuted.row(i) = x.row(order[i]);
+    }
+    return(permuted);
+}
+
+MatrixXd restore_rows(const MatrixXd &x, const vector<int> &order) {
+    MatrixXd restored(x.rows(), x.cols());
+    for (size_t i = 0; i < order.size(); i++) {
+        restored.row(order[i]) = x.row(i);
+    }
+    return(restored);
+}
+
+template <typename T> IntegerVector graph_order_t(const T &graph, const std::string &method, const bool fix_first) {
+    ThreadScope scope;
+    vector<int> order = graph_order(build_neighbors(graph), method, fix_first);
+    IntegerVector ret(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        ret[i] = order[i] + 1;
+    }
+    return(ret);
+}
+
+//' Order the nodes of a graph for cache locality.
+//'
+//' @noRd
+//' @param graph  the adjacency matrix
+//' @param method  the order: rcm, degree or community
+//' @param fix_first  boolean if the first node stays in front
+//' @return  returns the (1-based) permutation of the nodes
+// [[Rcpp::export]]
+IntegerVector graph_order_s(const MSpMat &graph, const std::string &method, const bool fix_first = false) {
+    return(graph_order_t(graph, method, fix_first));
+}
+
+//' Order the nodes of a graph for cache locality.
+//'
+//' @noRd
+//' @param graph  the adjacency matrix
+//' @param method  the order: rcm, degree or community
+//' @param fix_first  boolean if the first node stays in front
+//' @return  returns the (1-based) permutation of the nodes
+// [[Rcpp::export]]
+IntegerVector graph_order_d(const MMatrixXd &graph, const std::string &method, const bool fix_first = false) {
+    return(graph_order_t(graph, method, fix_first));
+}
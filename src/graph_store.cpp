@@ -0,0 +1,300 @@
+#include "../inst/include/labyrinth.h"
+#include <cstring>
+#include <fstream>
+
+#if !WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A binary store of square sparse matrices in the column-compressed layout
+// of dgCMatrix, which the kernels map as MSpMat without copying. The file is
+// mapped read-only and shared, so forked workers share its pages through the
+// page cache rather than each holding a copy. Layout, in native byte order:
+//
+//   GraphStoreHeader
+//   for each matrix, at offset[m]:
+//     int32  outer[n + 1]      (the `p` slot), padded to 8 bytes
+//     int32  inner[nnz[m]]     (the `i` slot), padded to 8 bytes
+//     double values[nnz[m]]    (the `x` slot)
+//   names: n node names, each terminated by '\0', if names_bytes > 0
+//
+// The first matrix is the graph. The optional second and third ones are the
+// transition matrix of the random walk and its transpose: the columns of the
+// transpose are the rows of the transition matrix, which the power iteration
+// reads in place as CSR, and the forward push reads the columns.
+const char GRAPH_STORE_MAGIC[8] = {'L', 'B', 'Y', 'R', 'C', 'S', 'C', '\0'};
+const uint32_t GRAPH_STORE_VERSION = 1;
+const uint32_t GRAPH_STORE_BYTE_ORDER = 0x01020304;
+const size_t GRAPH_STORE_MAX_MATRICES = 3;
+
+struct GraphStoreHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t n;
+    uint64_t matrices;
+    uint64_t names_offset;
+    uint64_t names_bytes;
+    uint64_t offset[GRAPH_STORE_MAX_MATRICES];
+    uint64_t nnz[GRAPH_STORE_MAX_MATRICES];
+};
+
+inline uint64_t align_to_8(const uint64_t &offset) {
+    return((offset + 7) & ~uint64_t(7));
+}
+
+// The offsets of inner and values within a matrix section, and its end
+inline uint64_t inner_offset(const uint64_t &offset, const uint64_t &n) {
+    return(align_to_8(offset + sizeof(int32_t) * (n + 1)));
+}
+
+inline uint64_t values_offset(const uint64_t &offset, const uint64_t &n, const uint64_t &nnz) {
+    return(align_to_8(inner_offset(offset, n) + sizeof(int32_t) * nnz));
+}
+
+inline uint64_t section_end(const uint64_t &offset, const uint64_t &n, const uint64_t &nnz) {
+    return(values_offset(offset, n, nnz) + sizeof(double) * nnz);
+}
+
+class GraphStore {
+public:
+    explicit GraphStore(const std::string &path) {
+#if WINDOWS
+        // No mmap: the file is read once into memory
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            stop("Cannot open the graph store: " + path);
+        }
+        buffer.resize(size_t(file.tellg()));
+        file.seekg(0);
+        file.read(buffer.data(), buffer.size());
+        data = buffer.data();
+        bytes = buffer.size();
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            stop("Cannot open the graph store: " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < off_t(sizeof(GraphStoreHeader))) {
+            close(fd);
+            stop("Not a graph store: " + path);
+        }
+        bytes = size_t(info.st_size);
+        void *mapped = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            stop("Cannot map the graph store: " + path);
+        }
+        data = static_cast<char *>(mapped);
+#endif
+        validate(path);
+    }
+
+    ~GraphStore() {
+#if !WINDOWS
+        if (data) {
+            munmap(data, bytes);
+        }
+#endif
+    }
+
+    GraphStore(const GraphStore &) = delete;
+    GraphStore &operator=(const GraphStore &) = delete;
+
+    size_t size() const {
+        return(header().n);
+    }
+
+    size_t matrices() const {
+        return(header().matrices);
+    }
+
+    // The kernels only read the matrix, the pages are mapped read-only
+    MSpMat matrix(const size_t &index) const {
+        const GraphStoreHeader &h = header();
+        uint64_t offset = h.offset[index], n = h.n, nnz = h.nnz[index];
+        return(MSpMat(Index(n), Index(n), Index(nnz),
+                      reinterpret_cast<int *>(data + offset),
+                      reinterpret_cast<int *>(data + inner_offset(offset, n)),
+                      reinterpret_cast<double *>(data + values_offset(offset, n, nnz))));
+    }
+
+    CharacterVector names() const {
+        const GraphStoreHeader &h = header();
+        CharacterVector names(h.names_bytes > 0 ? h.n : 0);
+        const char *name = data + h.names_offset;
+        for (R_xlen_t i = 0; i < names.size(); i++) {
+            names[i] = std::string(name);
+            name += std::strlen(name) + 1;
+        }
+        return(names);
+    }
+
+private:
+    char *data = nullptr;
+    size_t bytes = 0;
+    vector<char> buffer;
+
+    const GraphStoreHeader &header() const {
+        return(*reinterpret_cast<const GraphStoreHeader *>(data));
+    }
+
+    // Only the header and the section bounds are checked, since reading every
+    // index would touch all the pages the mapping is meant to share
+    void validate(const std::string &path) const {
+        const GraphStoreHeader &h = header();
+        if (bytes < sizeof(GraphStoreHeader) || std::memcmp(h.magic, GRAPH_STORE_MAGIC, sizeof(GRAPH_STORE_MAGIC)) != 0) {
+            stop("Not a graph store: " + path);
+        }
+        if (h.byte_order != GRAPH_STORE_BYTE_ORDER) {
+            stop("The graph store was written with another byte order: " + path);
+        }
+        if (h.version != GRAPH_STORE_VERSION) {
+            stop("Unsupported graph store version " + std::to_string(h.version) + ": " + path);
+        }
+        if ((h.matrices != 1 && h.matrices != GRAPH_STORE_MAX_MATRICES) || h.n > uint64_t(std::numeric_limits<int>::max())) {
+            stop("Corrupted graph store: " + path);
+        }
+        for (size_t m = 0; m < h.matrices; m++) {
+            if (h.offset[m] % 8 != 0 || section_end(h.offset[m], h.n, h.nnz[m]) > bytes) {
+                stop("Corrupted graph store: " + path);
+            }
+            const int *outer = reinterpret_cast<const int *>(data + h.offset[m]);
+            if (outer[0] != 0 || uint64_t(outer[h.n]) != h.nnz[m]) {
+                stop("Corrupted graph store: " + path);
+            }
+        }
+        if (h.names_offset + h.names_bytes > bytes || (h.names_bytes > 0 && data[h.names_offset + h.names_bytes - 1] != '\0')) {
+            stop("Corrupted graph store: " + path);
+        }
+    }
+};
+
+MSpMat graph_store_matrix(SEXP store, const int &index) {
+    XPtr<GraphStore> pointer(store);
+    if (pointer.get() == nullptr) {
+        stop("The graph store is closed. Open it again with open_graph_store().");
+    }
+    if (index < 0 || size_t(index) >= pointer->matrices()) {
+        stop("The graph store has no transition matrix. Write it with transition = TRUE.");
+    }
+    return(pointer->matrix(index));
+}
+
+//' Write square sparse matrices to a graph store.
+//'
+//' @noRd
+//' @param matrices  list of dgCMatrix of the same size: the graph, and
+//'   optionally the transition matrix and its transpose
+//' @param names  the node names, or an empty vector
+//' @param path  the file to write
+//' @return  returns the number of bytes written
+// [[Rcpp::export]]
+double write_graph_store_(const List &matrices, const CharacterVector &names, const std::string &path) {
+    GraphStoreHeader header = {};
+    std::memcpy(header.magic, GRAPH_STORE_MAGIC, sizeof(GRAPH_STORE_MAGIC));
+    header.version = GRAPH_STORE_VERSION;
+    header.byte_order = GRAPH_STORE_BYTE_ORDER;
+    header.matrices = matrices.size();
+    if (header.matrices != 1 && header.matrices != GRAPH_STORE_MAX_MATRICES) {
+        stop("A graph store holds the graph, and optionally the transition matrix and its transpose.");
+    }
+
+    vector<MSpMat> maps;
+    uint64_t offset = align_to_8(sizeof(GraphStoreHeader));
+    for (size_t m = 0; m < header.matrices; m++) {
+        maps.push_back(as<MSpMat>(matrices[m]));
+        const MSpMat &matrix = maps.back();
+        if (m == 0) {
+            header.n = matrix.rows();
+        }
+        if (uint64_t(matrix.rows()) != header.n || uint64_t(matrix.cols()) != header.n) {
+            stop("The matrices of a graph store must be square and of the same size.");
+        }
+        header.offset[m] = offset;
+        header.nnz[m] = matrix.nonZeros();
+        offset = align_to_8(section_end(offset, header.n, header.nnz[m]));
+    }
+    if (names.size() > 0 && uint64_t(names.size()) != header.n) {
+        stop("There must be one name per node.");
+    }
+    header.names_offset = offset;
+    for (R_xlen_t i = 0; i < names.size(); i++) {
+        header.names_bytes += std::string(names[i]).size() + 1;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        stop("Cannot write the graph store: " + path);
+    }
+    const char padding[8] = {0};
+    auto write_at = [&](const uint64_t &position, const void *bytes, const uint64_t &size) {
+        file.write(padding, std::streamsize(position - uint64_t(file.tellp())));
+        file.write(static_cast<const char *>(bytes), std::streamsize(size));
+    };
+    write_at(0, &header, sizeof(GraphStoreHeader));
+    for (size_t m = 0; m < header.matrices; m++) {
+        const MSpMat &matrix = maps[m];
+        uint64_t n = header.n, nnz = header.nnz[m];
+        write_at(header.offset[m], matrix.outerIndexPtr(), sizeof(int32_t) * (n + 1));
+        write_at(inner_offset(header.offset[m], n), matrix.innerIndexPtr(), sizeof(int32_t) * nnz);
+        write_at(values_offset(header.offset[m], n, nnz), matrix.valuePtr(), sizeof(double) * nnz);
+    }
+    write_at(header.names_offset, nullptr, 0);
+    for (R_xlen_t i = 0; i < names.size(); i++) {
+        std::string name(names[i]);
+        file.write(name.c_str(), std::streamsize(name.size() + 1));
+    }
+    if (!file) {
+        stop("Cannot write the graph store: " + path);
+    }
+    return(double(file.tellp()));
+}
+
+//' Map a graph store into memory.
+//'
+//' @noRd
+//' @param path  the file written by write_graph_store_()
+//' @return  returns a list with the external pointer to the store, the number
+//'   of nodes, the number of matrices and the node names
+// [[Rcpp::export]]
+List open_graph_store_(const std::string &path) {
+    XPtr<GraphStore> pointer(new GraphStore(path), true);
+    return(List::create(Named("pointer") = pointer,
+                        Named("n") = double(pointer->size()),
+                        Named("matrices") = int(pointer->matrices()),
+                        Named("names") = pointer->names()));
+}
+
+//' Sum the row and the column of a node in the graph of a graph store.
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store
+//' @param node  the (0-based) index of the node
+//' @return  returns graph[node, ] + graph[, node]
+// [[Rcpp::export]]
+NumericVector graph_store_links_(SEXP store, const int &node) {
+    const MSpMat graph = graph_store_matrix(store, 0);
+    if (node < 0 || node >= graph.rows()) {
+        stop("The node is out of range.");
+    }
+    NumericVector links(graph.rows());
+    for (MSpMat::InnerIterator it(graph, node); it; ++it) {
+        links[it.index()] += it.value();
+    }
+    // The row indices of every column are sorted in a dgCMatrix
+    const int *outer = graph.outerIndexPtr(), *inner = graph.innerIndexPtr();
+    const double *values = graph.valuePtr();
+    for (Index col = 0; col < graph.cols(); col++) {
+        const int *last = inner + outer[col + 1];
+        const int *found = std::lower_bound(inner + outer[col], last, node);
+        if (found != last && *found == node) {
+            links[col] += values[found - inner];
+        }
+    }
+    return(links);
+}
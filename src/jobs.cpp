@@ -0,0 +1,256 @@
+#include "../inst/include/labyrinth.h"
+#include <thread>
+#include <R_ext/Rdynload.h>
+
+// Background jobs of the kernels. A pool of threads takes the jobs in the
+// order they were submitted, and every job runs its kernel with an OpenMP
+// team of its own, so the default of one worker gives each job all the
+// threads while the next ones wait.
+const char *JOB_STATES[] = {"queued", "running", "done", "cancelled", "failed"};
+
+void run_job(Job &job) {
+    int state = JOB_CANCELLED;
+    if (!job.cancelled) {
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.started = wall_seconds();
+        }
+        job.state = JOB_RUNNING;
+        // The budget is a setting of the calling thread, so it only applies
+        // to this worker
+        ThreadScope scope(job.threads);
+        std::string error;
+        try {
+            job.work(job);
+            state = job.cancelled ? JOB_CANCELLED : JOB_DONE;
+        } catch (const std::exception &e) {
+            error = e.what();
+            state = JOB_FAILED;
+        } catch (...) {
+            error = "Unknown error.";
+            state = JOB_FAILED;
+        }
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.error = error;
+    }
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.finished = wall_seconds();
+    job.state = state;
+    job.changed.notify_all();
+}
+
+class JobPool {
+public:
+    ~JobPool() {
+        shutdown();
+    }
+
+    void submit(const std::shared_ptr<Job> &job, const size_t &workers) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(job);
+        while (threads.size() < workers) {
+            threads.emplace_back(&JobPool::work, this);
+        }
+        ready.notify_one();
+    }
+
+    // Cancel every job and join the workers. A running kernel stops at its
+    // next check of the cancellation, such as the end of a sweep
+    void shutdown() {
+        vector<std::shared_ptr<Job>> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            for (auto &job : running) {
+                job->cancelled = true;
+            }
+            dropped.assign(queue.begin(), queue.end());
+            queue.clear();
+        }
+        ready.notify_all();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+        for (auto &job : dropped) {
+            job->cancelled = true;
+            run_job(*job);
+        }
+        stopping = false;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::shared_ptr<Job>> queue;
+    vector<std::shared_ptr<Job>> running;
+    vector<std::thread> threads;
+    bool stopping = false;
+
+    void work() {
+        while (true) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&]() {
+                    return(stopping || !queue.empty());
+                });
+                if (stopping) {
+                    return;
+                }
+                job = queue.front();
+                queue.pop_front();
+                running.push_back(job);
+            }
+            run_job(*job);
+            std::lock_guard<std::mutex> lock(mutex);
+            running.erase(std::find(running.begin(), running.end(), job));
+        }
+    }
+};
+
+JobPool &job_pool() {
+    static JobPool pool;
+    return(pool);
+}
+
+// A handle dropped by R cancels its job, whose result nobody can collect
+void release_job(std::shared_ptr<Job> *job) {
+    (*job)->cancelled = true;
+    delete job;
+}
+
+typedef XPtr<std::shared_ptr<Job>, PreserveStorage, release_job, false> JobPointer;
+
+SEXP submit_job(const std::shared_ptr<Job> &job, const int &workers) {
+    job->submitted = wall_seconds();
+    job_pool().submit(job, size_t(std::max(workers, 1)));
+    return(JobPointer(new std::shared_ptr<Job>(job), true));
+}
+
+Job &job_handle(SEXP pointer) {
+    JobPointer handle(pointer);
+    if (handle.get() == nullptr) {
+        stop("The job handle is no longer valid.");
+    }
+    return(**handle);
+}
+
+// Wait until the job finishes or for `timeout` seconds (forever if
+// negative), waking up to check the user interrupts of the session
+bool wait_job(Job &job, const double &timeout, const std::function<bool()> &done) {
+    double deadline = timeout < 0 ? INFINITY : wall_seconds() + timeout;
+    std::unique_lock<std::mutex> lock(job.mutex);
+    while (!done()) {
+        double left = deadline - wall_seconds();
+        if (left <= 0) {
+            return(false);
+        }
+        job.changed.wait_for(lock, std::chrono::duration<double>(std::min(left, 0.1)));
+        lock.unlock();
+        checkUserInterrupt();
+        lock.lock();
+    }
+    return(true);
+}
+
+//' Report the state of a background job.
+//'
+//' @noRd
+//' @param job  the external pointer of a job
+//' @return  returns a list of the state, the progress (done of total units),
+//'   the latest loss of each seed, the seconds running and the error
+// [[Rcpp::export]]
+List job_status_(SEXP job) {
+    Job &handle = job_handle(job);
+    NumericVector loss;
+    std::string error;
+    int state;
+    double seconds = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(handle.mutex);
+        loss = NumericVector(handle.loss.begin(), handle.loss.end());
+        error = handle.error;
+        state = handle.state;
+        if (handle.started > 0) {
+            seconds = (state >= JOB_DONE ? handle.finished : wall_seconds()) - handle.started;
+        }
+    }
+    return(List::create(Named("state") = JOB_STATES[state],
+                        Named("done") = double(handle.done),
+                        Named("total") = double(handle.total),
+                        Named("loss") = loss,
+                        Named("seconds") = seconds,
+                        Named("error") = error));
+}
+
+//' Cancel a background job.
+//'
+//' @noRd
+//' @param job  the external pointer of a job
+//' @return  returns whether the job was still queued or running
+// [[Rcpp::export]]
+bool job_cancel_(SEXP job) {
+    Job &handle = job_handle(job);
+    handle.cancelled = true;
+    return(handle.state < JOB_DONE);
+}
+
+//' Collect the result of a background job.
+//'
+//' @noRd
+//' @param job  the external pointer of a job
+//' @param timeout  the seconds to wait for the job, or negative to wait until
+//'   it finishes
+//' @return  returns the result of the kernel, which is partial if the job was
+//'   cancelled, or NULL if the job is not finished or never started
+// [[Rcpp::export]]
+SEXP job_result_(SEXP job, const double timeout = -1.0) {
+    Job &handle = job_handle(job);
+    if (!wait_job(handle, timeout, [&]() {
+        return(handle.state >= JOB_DONE);
+    })) {
+        return(R_NilValue);
+    }
+    if (handle.state == JOB_FAILED) {
+        stop("The job failed: " + handle.error);
+    }
+    if (handle.started == 0) {
+        return(R_NilValue);
+    }
+    return(handle.collect());
+}
+
+//' Fetch the partial result of a running job.
+//'
+//' @noRd
+//' @param job  the external pointer of a job
+//' @param timeout  the seconds to wait for the kernel to publish it, at the
+//'   end of its current sweep or block
+//' @return  returns the partial activation in the order of the graph, or
+//'   NULL if there is none yet
+// [[Rcpp::export]]
+SEXP job_partial_(SEXP job, const double timeout = 5.0) {
+    Job &handle = job_handle(job);
+    size_t version;
+    {
+        std::lock_guard<std::mutex> lock(handle.mutex);
+        version = handle.partial_version;
+    }
+    if (handle.state < JOB_DONE) {
+        handle.partial_requested = true;
+        wait_job(handle, timeout, [&]() {
+            return(handle.partial_version != version || handle.state >= JOB_DONE);
+        });
+    }
+    std::lock_guard<std::mutex> lock(handle.mutex);
+    if (handle.partial_version == 0) {
+        return(R_NilValue);
+    }
+    return(wrap(handle.partial));
+}
+
+// Join the workers before the library is unloaded, since they run its code
+extern "C" void R_unload_labyrinth(DllInfo *) {
+    job_pool().shutdown();
+}
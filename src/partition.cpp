@@ -0,0 +1,167 @@
+#include "../inst/include/labyrinth.h"
+#if !WINDOWS
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Partitioned kernels run on several processes forked from the session,
+// each owning a block of rows of the graph. The processes exchange their rows
+// through a SharedSegment and step together through its barrier, so the
+// rows a process reads from the others (its halo) are whatever they wrote
+// before the last barrier.
+
+// The atomics must work across processes, which lock-free ones do
+static_assert(std::atomic<int>::is_always_lock_free, "Process-shared barriers need lock-free atomics.");
+
+struct SharedSegment::Control {
+    std::atomic<int> arrived, generation, failed;
+    int processes;
+    long session;
+};
+
+// The control and the process ids of the workers take cache lines of their
+// own, so the arrays that follow do not share them with the spinning
+// processes
+size_t SharedSegment::control_bytes(const int &processes) {
+    return((sizeof(Control) + sizeof(long) * processes + 63) / 64 * 64);
+}
+
+SharedSegment::SharedSegment(const size_t &bytes, const int &processes) {
+#if WINDOWS
+    stop("Partitioned runs need fork(), which is not available on Windows.");
+#else
+    mapped = control_bytes(processes) + bytes;
+    // Anonymous shared pages are zero and stay shared through fork()
+    void *pointer = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (pointer == MAP_FAILED) {
+        stop("Cannot map " + std::to_string(mapped) + " bytes of shared memory.");
+    }
+    control = new (pointer) Control();
+    control->processes = processes;
+    control->session = long(getpid());
+    data = static_cast<char *>(pointer) + control_bytes(processes);
+#endif
+}
+
+SharedSegment::~SharedSegment() {
+#if !WINDOWS
+    if (control) {
+        munmap(control, mapped);
+    }
+#endif
+}
+
+int SharedSegment::processes() const {
+    return(control->processes);
+}
+
+void SharedSegment::fail() {
+    control->failed = 1;
+}
+
+// The process ids of the workers follow the control, by rank (0 unused)
+long *SharedSegment::workers() const {
+    return(reinterpret_cast<long *>(control + 1));
+}
+
+void SharedSegment::watch(const vector<long> &pids) {
+    if (pids.size() + 1 != size_t(control->processes)) {
+        stop("A partitioned run needs the process id of every worker.");
+    }
+    std::copy(pids.begin(), pids.end(), workers() + 1);
+}
+
+// Whether a watched worker has exited. waitid() with WNOWAIT leaves an exited
+// worker to be reaped by mccollect(), and fails if the SIGCHLD handler of the
+// parallel package has reaped it already
+bool SharedSegment::exited() const {
+#if !WINDOWS
+    const long *pids = workers();
+    for (int rank = 1; rank < control->processes; rank++) {
+        if (pids[rank] <= 0) {
+            continue;
+        }
+        siginfo_t info;
+        info.si_pid = 0;
+        if (waitid(P_PID, id_t(pids[rank]), &info, WEXITED | WNOHANG | WNOWAIT) != 0 || info.si_pid != 0) {
+            return(true);
+        }
+    }
+#endif
+    return(false);
+}
+
+// A sense-counting barrier: the last process to arrive starts the next
+// generation. The others spin briefly, then sleep between checks, since a
+// step of a large graph takes far longer than a wake-up. A worker that dies
+// never arrives, so the session checks the watched workers while it waits,
+// and fails the run for all of them
+void SharedSegment::wait(const int &rank) {
+    if (control->failed) {
+        throw std::runtime_error("Another process of the partitioned run failed.");
+    }
+    int generation = control->generation.load(std::memory_order_acquire);
+    if (control->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == control->processes) {
+        control->arrived.store(0, std::memory_order_relaxed);
+        control->generation.fetch_add(1, std::memory_order_acq_rel);
+        return;
+    }
+    for (size_t spins = 0; control->generation.load(std::memory_order_acquire) == generation; spins++) {
+        if (control->failed) {
+            throw std::runtime_error("Another process of the partitioned run failed.");
+        }
+        if (spins < 1024) {
+            continue;
+        }
+#if !WINDOWS
+        if (rank == 0 && spins % 1024 == 0) {
+            if (Progress::check_abort()) {
+                fail();
+                throw std::runtime_error("The partitioned run was interrupted.");
+            }
+            if (exited()) {
+                fail();
+                throw std::runtime_error("A worker of the partitioned run exited.");
+            }
+        } else if (rank != 0 && long(getppid()) != control->session) {
+            fail();
+            throw std::runtime_error("The session of the partitioned run is gone.");
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+}
+
+SharedSegment *shared_segment(SEXP segment) {
+    XPtr<SharedSegment> pointer(segment);
+    if (pointer.get() == nullptr) {
+        stop("The shared segment is unmapped.");
+    }
+    return(pointer.get());
+}
+
+SEXP shared_segment(SharedSegment *segment) {
+    return(XPtr<SharedSegment>(segment, true));
+}
+
+//' Release the processes of a partitioned run.
+//'
+//' @noRd
+//' @param segment  the external pointer of the shared segment of the run
+//' @return  returns nothing; the processes waiting on the segment fail
+// [[Rcpp::export]]
+void shared_segment_fail_(SEXP segment) {
+    shared_segment(segment)->fail();
+}
+
+//' Watch the workers of a partitioned run.
+//'
+//' @noRd
+//' @param segment  the external pointer of the shared segment of the run
+//' @param pids  the process ids of the workers, by rank from 1
+//' @return  returns nothing; the session fails the run if a worker exits
+// [[Rcpp::export]]
+void shared_segment_watch_(SEXP segment, const NumericVector &pids) {
+    shared_segment(segment)->watch(as<vector<long>>(pids));
+}
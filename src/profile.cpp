@@ -0,0 +1,98 @@
+#include "../inst/include/labyrinth.h"
+
+KernelProfile::KernelProfile(const bool &enabled) : on(enabled) {
+    if (!on) {
+        return;
+    }
+    // Every profile reports these counters, even if the kernel leaves them
+    // at zero, so that profiles of different calls line up
+    for (const char *counter : {"iterations", "edges", "bytes"}) {
+        count(counter, 0.0);
+    }
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    busy_seconds.assign(threads, 0.0);
+    busy_calls.assign(threads, 0);
+}
+
+void KernelProfile::start(const std::string &phase) {
+    if (!on) {
+        return;
+    }
+    stop();
+    auto found = std::find(phase_names.begin(), phase_names.end(), phase);
+    running = int(found - phase_names.begin());
+    if (found == phase_names.end()) {
+        phase_names.push_back(phase);
+        phase_seconds.push_back(0.0);
+    }
+    phase_begin = wall_seconds();
+}
+
+void KernelProfile::stop() {
+    if (!on || running < 0) {
+        return;
+    }
+    phase_seconds[running] += wall_seconds() - phase_begin;
+    running = -1;
+}
+
+void KernelProfile::count(const std::string &counter, const double &value) {
+    if (!on) {
+        return;
+    }
+    auto found = std::find(counter_names.begin(), counter_names.end(), counter);
+    if (found == counter_names.end()) {
+        counter_names.push_back(counter);
+        counter_values.push_back(value);
+    } else {
+        counter_values[found - counter_names.begin()] += value;
+    }
+}
+
+double KernelProfile::now() const {
+    return(on ? wall_seconds() : 0.0);
+}
+
+// Called by every thread of a team, each writing its own slot
+void KernelProfile::busy(const double &begin) {
+    if (!on) {
+        return;
+    }
+    size_t thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    if (thread < busy_seconds.size()) {
+        busy_seconds[thread] += wall_seconds() - begin;
+        busy_calls[thread]++;
+    }
+}
+
+List KernelProfile::summary() {
+    if (!on) {
+        return(List());
+    }
+    stop();
+    NumericVector phases(phase_seconds.begin(), phase_seconds.end());
+    phases.names() = CharacterVector(phase_names.begin(), phase_names.end());
+    NumericVector counters(counter_values.begin(), counter_values.end());
+    counters.names() = CharacterVector(counter_names.begin(), counter_names.end());
+
+    // Only the threads of the teams that ran, which may be fewer than the
+    // slots with a smaller thread budget
+    vector<double> busy;
+    for (size_t thread = 0; thread < busy_seconds.size(); thread++) {
+        if (busy_calls[thread] > 0) {
+            busy.push_back(busy_seconds[thread]);
+        }
+    }
+    double mean = busy.empty() ? 0.0 : std::accumulate(busy.begin(), busy.end(), 0.0) / double(busy.size());
+    double imbalance = (mean > 0) ? *std::max_element(busy.begin(), busy.end()) / mean : NAN;
+    return(List::create(Named("phases") = phases,
+                        Named("counters") = counters,
+                        Named("thread_busy") = NumericVector(busy.begin(), busy.end()),
+                        Named("imbalance") = imbalance));
+}
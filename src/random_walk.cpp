@@ -1,4 +1,535 @@
 #include "../inst/include/labyrinth.h"
+#include <unordered_map>
+
+// Markov random walk with restart on a column-normalised adjacency matrix W:
+//   p(t + 1) = (1 - r) W p(t) + r p(0).
+// All seeds (columns of p0) are walked together in blocks, so that each read
+// of W is shared by the whole block. Every column stops on its own, once the
+// L1 distance between two steps drops below the threshold.
+
+// The next step of a block of seeds, without the restart: next = W * current.
+// W is read row-wise (a row-major matrix, or the map of the rows from
+// transition_rows()) so that every row of the result belongs to one task.
+// The rows are walked in edge-balanced tasks, and the rows of hubs split across
+// tasks are reduced in task order. The tasks run on OpenMP, or on `workers`
+// threads of their own in the processes forked from the session, which cannot
+// use its OpenMP runtime.
+template <typename Scalar, typename S, typename C>
+inline void rwr_product(const SparseMatrixBase<S> &rows, const C &current, Matrix<Scalar, Dynamic, Dynamic, RowMajor> &next, const int &workers = 0) {
+    typedef Matrix<Scalar, 1, Dynamic> Row;
+    static_assert(S::IsRowMajor, "The product reads W by rows");
+    const S &W = rows.derived();
+    const vector<EdgeTask> tasks = partition_edges(W.outerIndexPtr(), W.outerSize());
+    const int *inner = W.innerIndexPtr();
+    const Scalar *value = W.valuePtr();
+    vector<Row> partials(tasks.size());
+    next.resize(W.rows(), current.cols());
+
+    auto run_task = [&](const size_t &t) {
+        const EdgeTask &task = tasks[t];
+        if (task.split) {
+            partials[t].setZero(current.cols());
+            for (size_t k = task.first_edge; k < task.last_edge; k++) {
+                partials[t] += value[k] * current.row(inner[k]);
+            }
+            return;
+        }
+        for (size_t i = task.first_node; i < task.last_node; i++) {
+            next.row(i).setZero();
+            for (typename S::InnerIterator it(W, i); it; ++it) {
+                next.row(i) += it.value() * current.row(it.index());
+            }
+        }
+    };
+    TaskQueue queue(tasks.size());
+    parallel_region(workers, [&]() {
+        for (size_t t; queue.take(t);) {
+            run_task(t);
+        }
+    });
+
+    for (size_t t = 0; t < tasks.size(); t++) {
+        const EdgeTask &task = tasks[t];
+        if (!task.split) {
+            continue;
+        }
+        if (task.first_edge == size_t(W.outerIndexPtr()[task.first_node])) {
+            next.row(task.first_node) = partials[t];
+        } else {
+            next.row(task.first_node) += partials[t];
+        }
+    }
+}
+
+// Dense W goes to the (multi-threaded) matrix product of Eigen
+template <typename Scalar, typename T>
+inline void rwr_product(const MatrixBase<T> &W, const Matrix<Scalar, Dynamic, Dynamic, RowMajor> &current, Matrix<Scalar, Dynamic, Dynamic, RowMajor> &next) {
+    next.noalias() = W * current;
+}
+
+// The seeds walked together, which share every read of W
+const Index RWR_BLOCK = 16;
+
+// Keep the given columns of a block, in order
+template <typename Scalar>
+inline void keep_columns(Matrix<Scalar, Dynamic, Dynamic, RowMajor> &block, const vector<Index> &kept) {
+    Matrix<Scalar, Dynamic, Dynamic, RowMajor> compacted(block.rows(), kept.size());
+    for (size_t i = 0; i < kept.size(); i++) {
+        compacted.col(i) = block.col(kept[i]);
+    }
+    block.swap(compacted);
+}
+
+// The L1 distances between two steps of a block over the chunks of the rows
+// [first, last), one row of stride RWR_BLOCK per chunk in `sums`
+template <typename Scalar, typename A, typename B>
+inline void l1_chunks(const A &next, const B &current, const Index &first, const Index &last, Scalar *sums) {
+    chunk_sums(
+        [&](const Index &row, const Index &column) {
+            return(std::abs(next(row, column) - current(row, column)));
+        },
+        first, last, next.cols(), sums, RWR_BLOCK);
+}
+
+// Power iteration over blocks of seeds in precision Scalar. Fills the
+// stationary distributions, and the iterations and the last L1 step of every
+// column. The iteration starts from p0, or from `start` if not empty: the
+// fixed point is the same, and a start close to it, such as the distribution
+// of a similar seed, converges in fewer iterations.
+template <typename Scalar, typename T>
+void mrwr_iterate(const T &W, const MatrixXd &p0, const MatrixXd &start, const double r, const double thresh, const int niter, MatrixXd &pt, VectorXi &iterations, VectorXd &residual) {
+    typedef Matrix<Scalar, Dynamic, Dynamic, RowMajor> Block;
+    const Index n = p0.rows(), seeds = p0.cols();
+
+    for (Index first = 0; first < seeds; first += RWR_BLOCK) {
+        Index width = std::min(RWR_BLOCK, seeds - first);
+        Block restart = p0.middleCols(first, width).template cast<Scalar>() * Scalar(r);
+        Block current = (start.size() > 0 ? start : p0).middleCols(first, width).template cast<Scalar>();
+        Block next(n, width), chunks(partition_chunks(n), RWR_BLOCK);
+        vector<Index> active(width);
+        std::iota(active.begin(), active.end(), first);
+
+        int iter = 0;
+        while (!active.empty() && iter < niter) {
+            if (Progress::check_abort()) {
+                break;
+            }
+            rwr_product(W, current, next);
+            next = next * Scalar(1.0 - r) + restart;
+            iter++;
+
+            // The L1 step adds up chunks of rows, as the partitioned walk does
+            l1_chunks(next, current, 0, n, chunks.data());
+            Matrix<Scalar, 1, Dynamic> step = add_chunks(chunks.data(), chunks.rows(), next.cols(), RWR_BLOCK);
+            vector<Index> kept;
+            for (size_t i = 0; i < active.size(); i++) {
+                iterations[active[i]] = iter;
+                residual[active[i]] = double(step[i]);
+                if (step[i] < thresh) {
+                    pt.col(active[i]) = next.col(i).template cast<double>();
+                } else {
+                    kept.push_back(i);
+                }
+            }
+
+            // Drop converged columns
+            if (kept.size() < active.size()) {
+                vector<Index> kept_seeds;
+                for (Index i : kept) {
+                    kept_seeds.push_back(active[i]);
+                }
+                keep_columns(next, kept);
+                keep_columns(restart, kept);
+                active.swap(kept_seeds);
+            }
+            current.swap(next);
+        }
+
+        // Columns that never converge
+        for (size_t i = 0; i < active.size(); i++) {
+            pt.col(active[i]) = current.col(i).template cast<double>();
+        }
+    }
+}
+
+// The analytical solution p = r (I - (1 - r) W)^-1 p0
+MatrixXd mrwr_analytical(const MatrixXd &W, const MatrixXd &p0, const double r) {
+    MatrixXd T = MatrixXd::Identity(W.rows(), W.cols()) - (1.0 - r) * W;
+    return(r * T.partialPivLu().solve(p0));
+}
+
+MatrixXd mrwr_analytical(const SpMat &W, const MatrixXd &p0, const double r) {
+    SpMat identity(W.rows(), W.cols());
+    identity.setIdentity();
+    SpMat T = identity - (1.0 - r) * W;
+    SparseLU<SpMat> solver;
+    solver.compute(T);
+    if (solver.info() != Success) {
+        stop("The analytical solution cannot be computed: I - (1 - r) W is singular.");
+    }
+    MatrixXd pt = solver.solve(p0);
+    return(r * pt);
+}
+
+MatrixXd mrwr_analytical(const MSpMatR &W, const MatrixXd &p0, const double r) {
+    return(mrwr_analytical(SpMat(W), p0, r));
+}
+
+template <typename T> List mrwr_t(const MatrixXd &p0, const T &W, const double r, const double thresh, const int niter, const bool do_analytical, int threads, const MatrixXd &start) {
+    Index seeds = p0.cols();
+    if (start.size() > 0 && (start.rows() != p0.rows() || start.cols() != seeds)) {
+        stop("The start must have the same size as p0.");
+    }
+    MatrixXd pt(p0.rows(), seeds);
+    VectorXi iterations = VectorXi::Zero(seeds);
+    VectorXd residual = VectorXd::Constant(seeds, NAN);
+
+    ThreadScope scope(threads);
+
+    Progress p(seeds, false);
+    // The iteration runs in the precision W is stored in
+    typedef typename T::Scalar Scalar;
+    if constexpr (std::is_same<Scalar, double>::value) {
+        if (do_analytical) {
+            pt = mrwr_analytical(W, p0, r);
+            residual = ((1.0 - r) * (W * pt) + r * p0 - pt).cwiseAbs().colwise().sum().transpose();
+        } else {
+            mrwr_iterate<Scalar>(W, p0, start, r, thresh, niter, pt, iterations, residual);
+        }
+    } else {
+        mrwr_iterate<Scalar>(W, p0, start, r, thresh, niter, pt, iterations, residual);
+    }
+
+    return(List::create(Named("p.inf") = pt,
+                        Named("iterations") = iterations,
+                        Named("residual") = residual));
+}
+
+// The transition matrix in float32 for the single precision, converted once
+// by prepare_model() and kept behind an external pointer: the rows of a sparse
+// W, or a dense W. Every query of the model walks it without converting W
+// again, and each step reads half the bytes of W in double.
+struct FloatTransition {
+    SparseMatrix<float, RowMajor> rows;
+    MatrixXf dense;
+};
+
+SEXP float_transition(FloatTransition *transition) {
+    return(XPtr<FloatTransition>(transition, true));
+}
+
+// The power iteration partitioned over processes forked from the session,
+// see partitioned_walk() in R. Every process owns a block of rows of W, with
+// about the same number of edges, and reads them in place from the rows of W.
+// W is neither copied nor mapped again: the workers inherit the pages of the
+// session (from R or from the mapped graph store) and only touch those of
+// their rows. The two steps and the restart of a block of seeds live in a
+// SharedSegment. Each process writes its rows of the next step, reading any
+// row of the current one, and the L1 steps of the chunks of its rows (see
+// PARTITION_CHUNK). After the barrier, rank 0 adds up the L1 steps of the
+// chunks in the order mrwr_iterate() does, so the columns stop at the same
+// iterations, then stores the converged columns and picks the columns to
+// keep. Every process moves the kept columns of its own rows. So rank 0 only
+// does O(n / PARTITION_CHUNK) work per column and step besides storing a
+// converged column once.
+
+// The state of the block of seeds being walked, which rank 0 writes between
+// two barriers and the others read after the second. The steps and the
+// restart alternate between two buffers: `current` and `restart` are the ones
+// of the next step, and `compact` is set when the kept columns are moved there
+struct WalkState {
+    Index n, seeds, width;
+    int current, restart, compact, stop;
+};
+
+// The offsets of the arrays of a walk in its segment: the bounds of the rows
+// of every process, the state, the L1 steps of every chunk of rows, the kept
+// columns, the two steps and the two restarts
+struct WalkLayout {
+    size_t bounds, state, l1, kept, steps[2], restart[2], bytes;
+
+    WalkLayout(const Index &n, const int &processes) {
+        auto align = [](const size_t &offset) {
+            return((offset + 63) / 64 * 64);
+        };
+        const size_t block = sizeof(double) * n * RWR_BLOCK;
+        bounds = 0;
+        state = align(sizeof(Index) * (processes + 1));
+        l1 = align(state + sizeof(WalkState));
+        kept = align(l1 + sizeof(double) * partition_chunks(n) * RWR_BLOCK);
+        steps[0] = align(kept + sizeof(Index) * RWR_BLOCK);
+        steps[1] = align(steps[0] + block);
+        restart[0] = align(steps[1] + block);
+        restart[1] = align(restart[0] + block);
+        bytes = restart[1] + block;
+    }
+};
+
+// The rows [first, first + rows) of W, mapped in place: the row pointers
+// keep their offsets into the column indices and values of the whole W
+inline MSpMatR row_block(const MSpMatR &W, const Index &first, const Index &rows) {
+    int *outer = const_cast<int *>(W.outerIndexPtr()) + first;
+    return(MSpMatR(rows, W.cols(), outer[rows] - outer[0], outer,
+                   const_cast<int *>(W.innerIndexPtr()), const_cast<double *>(W.valuePtr())));
+}
+
+// Map the segment of a walk of `seeds` seeds over W by `processes`
+// processes, with the rows balanced by their edges, see partition_rows()
+SEXP walk_segment_t(const MSpMatR &W, const int &seeds, const int &processes) {
+    if (processes < 1 || seeds < 1) {
+        stop("A partitioned walk needs at least one process and one seed.");
+    }
+    const Index n = W.rows();
+    WalkLayout layout(n, processes);
+    SharedSegment *segment = new SharedSegment(layout.bytes, processes);
+    RObject pointer = shared_segment(segment);
+
+    const vector<Index> bounds = partition_rows(W.outerIndexPtr(), n, processes);
+    std::copy(bounds.begin(), bounds.end(), segment->array<Index>(layout.bounds));
+
+    WalkState *state = segment->array<WalkState>(layout.state);
+    state->n = n;
+    state->seeds = seeds;
+    return(pointer);
+}
+
+// Run the part `rank` of a walk on `threads` threads. Rank 0 sets up every
+// block of seeds from p0 (or start) and fills pt, iterations and residual as
+// mrwr_iterate() does
+void walk_iterate(SharedSegment *segment, const int &rank, const MSpMatR &W, const double &r, const MatrixXd &p0, const double &thresh, const int &niter, const MatrixXd &start, const int &threads, MatrixXd &pt, VectorXi &iterations, VectorXd &residual) {
+    typedef Matrix<double, Dynamic, Dynamic, RowMajor> Block;
+    const int processes = segment->processes();
+    WalkLayout layout(W.rows(), processes);
+    WalkState *state = segment->array<WalkState>(layout.state);
+    const Index n = state->n, seeds = state->seeds;
+    const Index *bounds = segment->array<Index>(layout.bounds);
+    const Index first_row = bounds[rank], rows = bounds[rank + 1] - first_row;
+    double *steps[2] = {segment->array<double>(layout.steps[0]), segment->array<double>(layout.steps[1])};
+    double *restarts[2] = {segment->array<double>(layout.restart[0]), segment->array<double>(layout.restart[1])};
+    double *l1 = segment->array<double>(layout.l1);
+    Index *kept = segment->array<Index>(layout.kept);
+
+    try {
+        const MSpMatR local = row_block(W, first_row, rows);
+        Block next_rows;
+        for (Index first = 0; first < seeds; first += RWR_BLOCK) {
+            vector<Index> active;
+            int iter = 0;
+            // Every rank has read the end of the last block before rank 0
+            // sets up this one
+            segment->wait(rank);
+            if (rank == 0) {
+                Index width = std::min(RWR_BLOCK, seeds - first);
+                state->width = width;
+                state->current = 0;
+                state->restart = 0;
+                state->compact = 0;
+                state->stop = 0;
+                Map<Block>(restarts[0], n, width) = p0.middleCols(first, width) * r;
+                Map<Block>(steps[0], n, width) = (start.size() > 0 ? start : p0).middleCols(first, width);
+                active.resize(width);
+                std::iota(active.begin(), active.end(), first);
+            }
+            segment->wait(rank);
+
+            while (true) {
+                const Index width = state->width;
+                const int current_step = state->current, current_restart = state->restart;
+                Map<const Block> current(steps[current_step], n, width), restart_block(restarts[current_restart], n, width);
+                Map<Block> next(steps[1 - current_step], n, width);
+                rwr_product(local, current, next_rows, threads);
+                next.middleRows(first_row, rows) = next_rows * (1.0 - r) + restart_block.middleRows(first_row, rows);
+                l1_chunks(next, current, first_row, first_row + rows, l1);
+                segment->wait(rank);
+
+                if (rank == 0) {
+                    iter++;
+                    RowVectorXd step = add_chunks(l1, partition_chunks(n), width, RWR_BLOCK);
+                    vector<Index> kept_seeds;
+                    for (size_t i = 0; i < active.size(); i++) {
+                        iterations[active[i]] = iter;
+                        residual[active[i]] = step[i];
+                        if (step[i] < thresh) {
+                            pt.col(active[i]) = next.col(i);
+                        } else {
+                            kept[kept_seeds.size()] = Index(i);
+                            kept_seeds.push_back(active[i]);
+                        }
+                    }
+                    state->stop = kept_seeds.empty() || iter >= niter || Progress::check_abort();
+
+                    // Columns that never converge
+                    if (state->stop) {
+                        for (size_t i = 0; i < kept_seeds.size(); i++) {
+                            pt.col(kept_seeds[i]) = next.col(kept[i]);
+                        }
+                    }
+
+                    // Converged columns are dropped: the kept ones move to
+                    // the buffers of the current step and the other restart,
+                    // which nobody reads any more
+                    state->compact = !state->stop && Index(kept_seeds.size()) < width;
+                    state->width = Index(kept_seeds.size());
+                    state->current = state->compact ? current_step : 1 - current_step;
+                    state->restart = state->compact ? 1 - current_restart : current_restart;
+                    active.swap(kept_seeds);
+                }
+                segment->wait(rank);
+                if (state->stop) {
+                    break;
+                }
+                if (state->compact) {
+                    const Index kept_width = state->width;
+                    Map<Block> next_kept(steps[current_step], n, kept_width), restart_kept(restarts[1 - current_restart], n, kept_width);
+                    for (Index i = 0; i < kept_width; i++) {
+                        next_kept.col(i).segment(first_row, rows) = next.col(kept[i]).segment(first_row, rows);
+                        restart_kept.col(i).segment(first_row, rows) = restart_block.col(kept[i]).segment(first_row, rows);
+                    }
+                    segment->wait(rank);
+                }
+            }
+        }
+    } catch (...) {
+        segment->fail();
+        throw;
+    }
+}
+
+// Rank 0 runs in the session and returns the result of mrwr_t(); the other
+// ranks return an empty list
+List walk_partition_t(SEXP pointer, const int &rank, const MSpMatR &W, const double &r, const MatrixXd &p0, const double &thresh, const int &niter, const MatrixXd &start, const int &threads) {
+    SharedSegment *segment = shared_segment(pointer);
+    WalkLayout layout(W.rows(), segment->processes());
+    const WalkState *state = segment->array<WalkState>(layout.state);
+    const Index n = state->n, seeds = state->seeds;
+    if (rank < 0 || rank >= segment->processes() || n != W.rows()) {
+        stop("The segment does not belong to this walk.");
+    }
+    if (rank == 0 && (p0.rows() != n || p0.cols() != seeds)) {
+        stop("p0 must have one row per node and one column per seed.");
+    }
+    if (rank == 0 && start.size() > 0 && (start.rows() != n || start.cols() != seeds)) {
+        stop("The start must have the same size as p0.");
+    }
+
+    // The OpenMP runtime of the session is not safe to use in a forked child,
+    // so every process takes the tasks of its rows on `threads` threads of
+    // its own (see rwr_product()), and keeps Eigen to one thread
+    if (threads < 1) {
+        stop("A partitioned walk needs at least one thread per process.");
+    }
+    ThreadScope scope(1);
+    Progress p(seeds, false);
+    MatrixXd pt;
+    VectorXi iterations;
+    VectorXd residual;
+    if (rank == 0) {
+        pt.resize(n, seeds);
+        iterations = VectorXi::Zero(seeds);
+        residual = VectorXd::Constant(seeds, NAN);
+    }
+    walk_iterate(segment, rank, W, r, p0, thresh, niter, start, threads, pt, iterations, residual);
+    if (rank != 0) {
+        return(List());
+    }
+    return(List::create(Named("p.inf") = pt,
+                        Named("iterations") = iterations,
+                        Named("residual") = residual));
+}
+
+// Forward push (Andersen, Chung & Lang, 2006) approximates the same
+// stationary distribution locally. Every node keeps an estimate p and a
+// residual; pushing node u moves r * residual(u) into p(u) and spreads the rest
+// to the out-neighbors of u, i.e. the nonzeros in column u of W. Nodes are
+// pushed until every residual is at most epsilon. Since W is column-stochastic,
+// the L1 error of p is the residual mass left over, which is returned.
+//
+// Only the nodes reached by the mass are visited, so the state of a seed is a
+// hash map over those nodes and p is returned sparse: apart from reading the
+// seed column of p0, the work and memory of a seed do not depend on n.
+struct PushState {
+    double estimate = 0.0;
+    double residual = 0.0;
+    bool queued = false;
+};
+
+template <typename T> List ppr_push_t(const MMatrixXd &p0, const T &W, const double r, const double epsilon, int threads) {
+    Index n = p0.rows(), seeds = p0.cols();
+    vector<vector<Triplet<double>>> estimates(seeds);
+    VectorXi pushes = VectorXi::Zero(seeds);
+    VectorXd residual_mass(seeds);
+
+    ThreadScope scope(threads);
+
+    #pragma omp parallel
+    {
+        // Scratch of one thread, cleared after each seed
+        unordered_map<Index, PushState> state;
+        std::deque<Index> queue;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (Index seed = 0; seed < seeds; seed++) {
+            for (Index u = 0; u < n; u++) {
+                if (p0(u, seed) != 0.0) {
+                    PushState &node = state[u];
+                    node.residual = p0(u, seed);
+                    if (node.residual > epsilon) {
+                        node.queued = true;
+                        queue.push_back(u);
+                    }
+                }
+            }
+
+            int count = 0;
+            while (!queue.empty()) {
+                Index u = queue.front();
+                queue.pop_front();
+                PushState &node = state[u];
+                double mass = node.residual;
+                node.queued = false;
+                node.residual = 0.0;
+                node.estimate += r * mass;
+                count++;
+                for_each_out_edge(W, u, [&](const Index &v, const double &weight) {
+                    PushState &next = state[v];
+                    next.residual += (1.0 - r) * mass * weight;
+                    if (!next.queued && next.residual > epsilon) {
+                        next.queued = true;
+                        queue.push_back(v);
+                    }
+                });
+            }
+
+            double left = 0.0;
+            for (const auto &entry : state) {
+                left += entry.second.residual;
+                if (entry.second.estimate != 0.0) {
+                    estimates[seed].emplace_back(entry.first, seed, entry.second.estimate);
+                }
+            }
+            state.clear();
+            pushes[seed] = count;
+            residual_mass[seed] = left;
+        }
+    }
+
+    size_t nonzeros = 0;
+    for (const auto &column : estimates) {
+        nonzeros += column.size();
+    }
+    vector<Triplet<double>> triplets;
+    triplets.reserve(nonzeros);
+    for (const auto &column : estimates) {
+        triplets.insert(triplets.end(), column.begin(), column.end());
+    }
+    SpMat pt(n, seeds);
+    pt.setFromTriplets(triplets.begin(), triplets.end());
+
+    return(List::create(Named("p.inf") = pt,
+                        Named("iterations") = pushes,
+                        Named("residual") = residual_mass));
+}
+
 //' Do a Markon random walk (with restart) on an column-normalised adjacency
 //' matrix.
 //'
@@ -11,10 +542,14 @@
 //' @param niter  maximum number of iterations for the chain
 //' @param do_analytical  boolean if the stationary distribution shall be
 //'  computed solving the analytical solution or iteratively
-//' @return  returns the matrix of stationary distributions p_inf
+//' @param threads  the parallel threads, 0 for the default
+//' @param start  NULL or the matrix of distributions the iteration starts from
+//'   instead of p0, such as a previous solution
+//' @return  returns a list with the matrix of stationary distributions p_inf,
+//'   and the iterations and the last L1 step of each column
 // [[Rcpp::export]]
-VectorXd mrwr_(const MatrixXd& p0, const MatrixXd &W, const double r, const double thresh, const int niter, const bool do_analytical) {
-    return diffusr::mrwr_(p0, W, r, thresh, niter, do_analytical);
+List mrwr_(const MatrixXd& p0, const MMatrixXd &W, const double r, const double thresh, const int niter, const bool do_analytical, int threads = 0, Nullable<NumericMatrix> start = R_NilValue) {
+    return(mrwr_t(p0, W, r, thresh, niter, do_analytical, threads, optional_matrix(start)));
 }
 
 //' Do a Markon random walk (with restart) on an column-normalised adjacency
@@ -22,15 +557,239 @@ VectorXd mrwr_(const MatrixXd& p0, const MatrixXd &W, const double r, const doub
 //'
 //' @noRd
 //' @param p0  matrix of starting distribution
+//' @param W_t  the transpose of the column normalized adjacency matrix, from
+//'   transpose_transition_(), whose columns are read as the rows of W
+//' @param r  restart probability
+//' @param thresh  threshold to break as soon as new stationary distribution
+//'   converges to the stationary distribution of the previous timepoint
+//' @param niter  maximum number of iterations for the chain
+//' @param do_analytical  boolean if the stationary distribution shall be
+//'  computed solving the analytical solution or iteratively
+//' @param threads  the parallel threads, 0 for the default
+//' @param start  NULL or the matrix of distributions the iteration starts from
+//'   instead of p0, such as a previous solution
+//' @return  returns a list with the matrix of stationary distributions p_inf,
+//'   and the iterations and the last L1 step of each column
+// [[Rcpp::export]]
+List mrwr_s(const MatrixXd &p0, const MSpMat &W_t, const double r, const double thresh, const int niter, const bool do_analytical, int threads = 0, Nullable<NumericMatrix> start = R_NilValue) {
+    const MSpMatR W = transition_rows(W_t);
+    return(mrwr_t(p0, W, r, thresh, niter, do_analytical, threads, optional_matrix(start)));
+}
+
+//' Approximate a Markov random walk with restart by forward push.
+//'
+//' @noRd
+//' @param p0  matrix of starting distribution
+//' @param W  the column normalized adjacency matrix
+//' @param r  restart probability
+//' @param epsilon  the largest residual left on any node
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list with the sparse matrix of approximate stationary
+//'   distributions p_inf, and the pushes and the residual mass of each column
+// [[Rcpp::export]]
+List ppr_push_(const MMatrixXd &p0, const MMatrixXd &W, const double r, const double epsilon, int threads = 0) {
+    return(ppr_push_t(p0, W, r, epsilon, threads));
+}
+
+//' Approximate a Markov random walk with restart by forward push.
+//'
+//' @noRd
+//' @param p0  matrix of starting distribution
 //' @param W  the column normalized adjacency matrix
 //' @param r  restart probability
+//' @param epsilon  the largest residual left on any node
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list with the sparse matrix of approximate stationary
+//'   distributions p_inf, and the pushes and the residual mass of each column
+// [[Rcpp::export]]
+List ppr_push_s(const MMatrixXd &p0, const MSpMat &W, const double r, const double epsilon, int threads = 0) {
+    return(ppr_push_t(p0, W, r, epsilon, threads));
+}
+
+//' Do a Markon random walk (with restart) on the transition matrix of a graph
+//' store.
+//'
+//' @noRd
+//' @param p0  matrix of starting distribution
+//' @param store  the external pointer of a graph store with a transition matrix
+//' @param r  restart probability
 //' @param thresh  threshold to break as soon as new stationary distribution
 //'   converges to the stationary distribution of the previous timepoint
 //' @param niter  maximum number of iterations for the chain
 //' @param do_analytical  boolean if the stationary distribution shall be
 //'  computed solving the analytical solution or iteratively
-//' @return  returns the matrix of stationary distributions p_inf
+//' @param threads  the parallel threads, 0 for the default
+//' @param start  NULL or the matrix of distributions the iteration starts from
+//'   instead of p0, such as a previous solution
+//' @return  returns a list with the matrix of stationary distributions p_inf,
+//'   and the iterations and the last L1 step of each column
+// [[Rcpp::export]]
+List mrwr_m(const MatrixXd &p0, SEXP store, const double r, const double thresh, const int niter, const bool do_analytical, int threads = 0, Nullable<NumericMatrix> start = R_NilValue) {
+    const MSpMatR W = transition_rows(graph_store_matrix(store, 2));
+    return(mrwr_t(p0, W, r, thresh, niter, do_analytical, threads, optional_matrix(start)));
+}
+
+//' Approximate a Markov random walk with restart by forward push on the
+//' transition matrix of a graph store.
+//'
+//' @noRd
+//' @param p0  matrix of starting distribution
+//' @param store  the external pointer of a graph store with a transition matrix
+//' @param r  restart probability
+//' @param epsilon  the largest residual left on any node
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list with the sparse matrix of approximate stationary
+//'   distributions p_inf, and the pushes and the residual mass of each column
+// [[Rcpp::export]]
+List ppr_push_m(const MMatrixXd &p0, SEXP store, const double r, const double epsilon, int threads = 0) {
+    const MSpMat W = graph_store_matrix(store, 1);
+    return(ppr_push_t(p0, W, r, epsilon, threads));
+}
+
+//' Map the shared segment of a random walk partitioned over processes.
+//'
+//' @noRd
+//' @param W_t  the transpose of the column normalized adjacency matrix, from
+//'   transpose_transition_()
+//' @param seeds  the columns of p0
+//' @param processes  the processes of the walk, including the session
+//' @return  returns the external pointer of the segment
+// [[Rcpp::export]]
+SEXP walk_segment_s(const MSpMat &W_t, const int seeds, const int processes) {
+    return(walk_segment_t(transition_rows(W_t), seeds, processes));
+}
+
+//' Map the shared segment of a random walk partitioned over processes, on
+//' the transition matrix of a graph store.
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store with a transition matrix
+//' @param seeds  the columns of p0
+//' @param processes  the processes of the walk, including the session
+//' @return  returns the external pointer of the segment
+// [[Rcpp::export]]
+SEXP walk_segment_m(SEXP store, const int seeds, const int processes) {
+    return(walk_segment_t(transition_rows(graph_store_matrix(store, 2)), seeds, processes));
+}
+
+//' Run one process of a partitioned Markov random walk (with restart).
+//'
+//' @noRd
+//' @param segment  the external pointer of the segment of the walk
+//' @param rank  the process, 0 for the session
+//' @param W_t  the transpose of the column normalized adjacency matrix, from
+//'   transpose_transition_()
+//' @param r  restart probability
+//' @param p0  matrix of starting distribution, for rank 0
+//' @param thresh  threshold to break as soon as new stationary distribution
+//'   converges to the stationary distribution of the previous timepoint
+//' @param niter  maximum number of iterations for the chain
+//' @param start  NULL or the matrix of distributions the iteration starts from
+//'   instead of p0, such as a previous solution
+//' @param threads  the threads of the process
+//' @return  returns, for rank 0, a list with the matrix of stationary
+//'   distributions p_inf, and the iterations and the last L1 step of each
+//'   column, or an empty list
+// [[Rcpp::export]]
+List walk_partition_s(SEXP segment, const int rank, const MSpMat &W_t, const double r, Nullable<NumericMatrix> p0 = R_NilValue, const double thresh = 0, const int niter = 0, Nullable<NumericMatrix> start = R_NilValue, const int threads = 1) {
+    return(walk_partition_t(segment, rank, transition_rows(W_t), r, optional_matrix(p0), thresh, niter, optional_matrix(start), threads));
+}
+
+//' Run one process of a partitioned Markov random walk (with restart) on the
+//' transition matrix of a graph store.
+//'
+//' @noRd
+//' @param segment  the external pointer of the segment of the walk
+//' @param rank  the process, 0 for the session
+//' @param store  the external pointer of a graph store with a transition matrix
+//' @param r  restart probability
+//' @param p0  matrix of starting distribution, for rank 0
+//' @param thresh  threshold to break as soon as new stationary distribution
+//'   converges to the stationary distribution of the previous timepoint
+//' @param niter  maximum number of iterations for the chain
+//' @param start  NULL or the matrix of distributions the iteration starts from
+//'   instead of p0, such as a previous solution
+//' @param threads  the threads of the process
+//' @return  returns, for rank 0, a list with the matrix of stationary
+//'   distributions p_inf, and the iterations and the last L1 step of each
+//'   column, or an empty list
+// [[Rcpp::export]]
+List walk_partition_m(SEXP segment, const int rank, SEXP store, const double r, Nullable<NumericMatrix> p0 = R_NilValue, const double thresh = 0, const int niter = 0, Nullable<NumericMatrix> start = R_NilValue, const int threads = 1) {
+    const MSpMatR W = transition_rows(graph_store_matrix(store, 2));
+    return(walk_partition_t(segment, rank, W, r, optional_matrix(p0), thresh, niter, optional_matrix(start), threads));
+}
+
+//' Transpose the transition matrix of a random walk, whose columns are then
+//' the rows of the transition matrix that the power iteration reads.
+//'
+//' @noRd
+//' @param W  the column normalized adjacency matrix
+//' @return  returns t(W) as a dgCMatrix
+// [[Rcpp::export]]
+SpMat transpose_transition_(const MSpMat &W) {
+    return(SpMat(W.transpose()));
+}
+
+//' Convert the transition matrix of a random walk to float32.
+//'
+//' @noRd
+//' @param W_t  the transpose of the column normalized adjacency matrix, from
+//'   transpose_transition_()
+//' @return  returns the external pointer of the rows of W in float32
+// [[Rcpp::export]]
+SEXP float_transition_s(const MSpMat &W_t) {
+    FloatTransition *transition = new FloatTransition;
+    transition->rows = transition_rows(W_t).cast<float>();
+    return(float_transition(transition));
+}
+
+//' Convert the transition matrix of a random walk to float32.
+//'
+//' @noRd
+//' @param W  the column normalized adjacency matrix
+//' @return  returns the external pointer of W in float32
+// [[Rcpp::export]]
+SEXP float_transition_d(const MMatrixXd &W) {
+    FloatTransition *transition = new FloatTransition;
+    transition->dense = W.cast<float>();
+    return(float_transition(transition));
+}
+
+//' Convert the transition matrix of a graph store to float32.
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store with a transition matrix
+//' @return  returns the external pointer of the rows of W in float32
+// [[Rcpp::export]]
+SEXP float_transition_m(SEXP store) {
+    FloatTransition *transition = new FloatTransition;
+    transition->rows = transition_rows(graph_store_matrix(store, 2)).cast<float>();
+    return(float_transition(transition));
+}
+
+//' Do a Markon random walk (with restart) in float32 on a transition matrix
+//' from float_transition_s(), float_transition_d() or float_transition_m().
+//'
+//' @noRd
+//' @param p0  matrix of starting distribution
+//' @param transition  the external pointer of the transition matrix in float32
+//' @param r  restart probability
+//' @param thresh  threshold to break as soon as new stationary distribution
+//'   converges to the stationary distribution of the previous timepoint
+//' @param niter  maximum number of iterations for the chain
+//' @param threads  the parallel threads, 0 for the default
+//' @param start  NULL or the matrix of distributions the iteration starts from
+//'   instead of p0, such as a previous solution
+//' @return  returns a list with the matrix of stationary distributions p_inf,
+//'   and the iterations and the last L1 step of each column
 // [[Rcpp::export]]
-VectorXd mrwr_s(const MatrixXd &p0, const SpMat &W, const double r, const double thresh, const int niter, const bool do_analytical) {
-    return diffusr::mrwr_s(p0, W, r, thresh, niter, do_analytical);
+List mrwr_f(const MatrixXd &p0, SEXP transition, const double r, const double thresh, const int niter, int threads = 0, Nullable<NumericMatrix> start = R_NilValue) {
+    XPtr<FloatTransition> pointer(transition);
+    if (pointer.get() == nullptr) {
+        stop("The float32 transition matrix is gone. Prepare the model again with prepare_model().");
+    }
+    if (pointer->dense.size() > 0) {
+        return(mrwr_t(p0, pointer->dense, r, thresh, niter, false, threads, optional_matrix(start)));
+    }
+    return(mrwr_t(p0, pointer->rows, r, thresh, niter, false, threads, optional_matrix(start)));
 }
@@ -0,0 +1,103 @@
+#include "../inst/include/labyrinth.h"
+#include <cstring>
+
+// Hashes identifying the queries and models of the result cache of
+// predict_drugs(). FNV-1a, taking a 64-bit word per step instead of a byte,
+// which is eight times faster on the arrays of a large model. The product of
+// FNV-1a only carries the bits of a word upwards, and doubles such as 0 and 1
+// differ in their high bits alone, so every word is mixed by the finalizer of
+// splitmix64 before it is taken. The hashes only key the cache, they are not
+// meant to resist collisions on purpose.
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+inline uint64_t mix64(uint64_t word) {
+    word = (word ^ (word >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    word = (word ^ (word >> 27)) * 0x94d049bb133111ebULL;
+    return(word ^ (word >> 31));
+}
+
+inline uint64_t fnv1a(const void *data, const size_t &bytes, uint64_t hash = FNV_OFFSET) {
+    const unsigned char *first = static_cast<const unsigned char *>(data);
+    size_t words = bytes / sizeof(uint64_t);
+    for (size_t i = 0; i < words; i++) {
+        uint64_t word;
+        std::memcpy(&word, first + i * sizeof(uint64_t), sizeof(uint64_t));
+        hash = (hash ^ mix64(word)) * FNV_PRIME;
+    }
+    for (size_t i = words * sizeof(uint64_t); i < bytes; i++) {
+        hash = (hash ^ first[i]) * FNV_PRIME;
+    }
+    return(hash);
+}
+
+inline std::string hex_hash(const uint64_t &hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return(std::string(text));
+}
+
+// The dimensions are hashed first, so that the same values in another shape
+// give another hash
+template <typename T> std::string hash_graph_t(const T &graph) {
+    const uint64_t dims[2] = {uint64_t(graph.rows()), uint64_t(graph.cols())};
+    uint64_t hash = fnv1a(dims, sizeof(dims));
+    if constexpr (std::is_base_of<SparseMatrixBase<T>, T>::value) {
+        hash = fnv1a(graph.outerIndexPtr(), sizeof(int) * (graph.outerSize() + 1), hash);
+        hash = fnv1a(graph.innerIndexPtr(), sizeof(int) * graph.nonZeros(), hash);
+        hash = fnv1a(graph.valuePtr(), sizeof(double) * graph.nonZeros(), hash);
+    } else {
+        hash = fnv1a(graph.data(), sizeof(double) * graph.size(), hash);
+    }
+    return(hex_hash(hash));
+}
+
+//' Hash every column of a matrix.
+//'
+//' @noRd
+//' @param x  a matrix, such as the initial weights of the queries
+//' @return  returns the hexadecimal hash of each column
+// [[Rcpp::export]]
+CharacterVector hash_columns_(const MMatrixXd &x) {
+    CharacterVector hashes(x.cols());
+    for (Index col = 0; col < x.cols(); col++) {
+        hashes[col] = hex_hash(fnv1a(x.col(col).data(), sizeof(double) * x.rows()));
+    }
+    return(hashes);
+}
+
+//' Hash a graph.
+//'
+//' @noRd
+//' @param graph  the graph
+//' @return  returns the hexadecimal hash of the dimensions and the values
+// [[Rcpp::export]]
+std::string hash_graph_d(const MMatrixXd &graph) {
+    return(hash_graph_t(graph));
+}
+
+//' Hash a graph.
+//'
+//' @noRd
+//' @param graph  the graph
+//' @return  returns the hexadecimal hash of the dimensions and the `p`, `i`
+//'   and `x` slots
+// [[Rcpp::export]]
+std::string hash_graph_s(const MSpMat &graph) {
+    return(hash_graph_t(graph));
+}
+
+//' Hash every string of a character vector.
+//'
+//' @noRd
+//' @param x  a character vector, such as the settings of a query
+//' @return  returns the hexadecimal hash of each string
+// [[Rcpp::export]]
+CharacterVector hash_strings_(const CharacterVector &x) {
+    CharacterVector hashes(x.size());
+    for (R_xlen_t i = 0; i < x.size(); i++) {
+        std::string text(x[i]);
+        hashes[i] = hex_hash(fnv1a(text.data(), text.size()));
+    }
+    return(hashes);
+}
@@ -0,0 +1,183 @@
+#include "../inst/include/labyrinth.h"
+
+// The fused sigmoid kernel of Spread-gram. For the activation rates ax of the
+// neighbors of a node y, both the spreading step and the gradient need
+//   sum((1 - sigma(ax, ay)) * weight * ax) over the nonzero ax,
+// where sigma(ax, ay) = 1 - 1 / (1 + exp(ax * ay)) as in sigmoid_t(). The
+// kernel computes it in one pass without temporaries. It keeps 1 - sigma
+// rather than the likelihood itself, so it rounds the same way as the Eigen
+// expressions it replaces.
+//
+// The AVX2 and AVX-512 paths are selected at run time and evaluate
+// exp(-|t|) by a degree 13 Taylor polynomial after the Cody-Waite reduction,
+// which is within 1 ulp of std::exp on [-708, 0]. Below exp(-708) the
+// exponent is clamped, and t > log(DBL_MAX) gives a zero likelihood as
+// std::exp would, so only terms under 1e-300 are off.
+//
+// Error bound: 1 - sigma cancels, so a 1 ulp change of exp() can move a term
+// by up to eps * weight * |ax| (eps = 2^-52), and an ulp bound on the sum
+// itself does not exist when the terms are tiny. Against the Eigen expressions
+// used before, the SIMD paths stay within 2 * eps * weight * sum(|ax|) for
+// degrees up to 60, and within 5 * eps * weight * sum(|ax|) up to 2000, where
+// the order of summation starts to matter. The scalar path sums sequentially
+// and stays within 13 * eps * weight * sum(|ax|).
+
+// Reference implementation, also used for the tails of the vector paths
+static double sigmoid_weighted_sum_scalar(const double *ax, const size_t &size, const double &ay, const double &weight) {
+    double sum = 0.0;
+    for (size_t i = 0; i < size; i++) {
+        if (ax[i] != 0.0) {
+            double sigma = 1.0 - 1.0 / (1.0 + std::exp(ax[i] * ay));
+            sum += (1.0 - sigma) * weight * ax[i];
+        }
+    }
+    return(sum);
+}
+
+#if !WINDOWS && defined(__GNUC__) && defined(__x86_64__)
+#define LABYRINTH_SIGMOID_SIMD 1
+#include <immintrin.h>
+
+namespace {
+// log(DBL_MAX), beyond which exp() overflows to Inf
+const double EXP_OVERFLOW = 709.782712893384;
+// exp(-|t|) is clamped to exp(-708), which keeps 2^n a normal number
+const double EXP_CLAMP = 708.0;
+const double LOG2E = 1.4426950408889634;
+// fdlibm splitting of log(2), exact when multiplied by |n| < 2^11
+const double LN2_HI = 6.93147180369123816490e-01;
+const double LN2_LO = 1.90821492927058770002e-10;
+// 1 / k!, k = 13, ..., 0
+const double EXP_POLY[14] = {
+    1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0,
+    1.0 / 362880.0, 1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0,
+    1.0 / 24.0, 1.0 / 6.0, 1.0 / 2.0, 1.0, 1.0
+};
+}
+
+// exp(x) for x in [-708, 0]
+__attribute__((target("avx2,fma")))
+static inline __m256d exp_avx2(const __m256d &x) {
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_HI), x);
+    r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_LO), r);
+    __m256d p = _mm256_set1_pd(EXP_POLY[0]);
+    for (int k = 1; k < 14; k++) {
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_POLY[k]));
+    }
+    __m256i e = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+    e = _mm256_slli_epi64(_mm256_add_epi64(e, _mm256_set1_epi64x(1023)), 52);
+    return(_mm256_mul_pd(p, _mm256_castsi256_pd(e)));
+}
+
+__attribute__((target("avx2,fma")))
+static double sigmoid_weighted_sum_avx2(const double *ax, const size_t &size, const double &ay, const double &weight) {
+    const __m256d one = _mm256_set1_pd(1.0), zero = _mm256_setzero_pd();
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d acc = zero;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256d a = _mm256_loadu_pd(ax + i);
+        __m256d t = _mm256_mul_pd(a, _mm256_set1_pd(ay));
+        // u = exp(-|t|) never overflows, and 1 / (1 + exp(t)) is either
+        // 1 / (1 + u) or u / (1 + u). NaN passes through the min.
+        __m256d abs_t = _mm256_min_pd(_mm256_set1_pd(EXP_CLAMP), _mm256_andnot_pd(sign, t));
+        __m256d u = exp_avx2(_mm256_xor_pd(abs_t, sign));
+        __m256d numerator = _mm256_blendv_pd(one, u, _mm256_cmp_pd(t, zero, _CMP_GE_OQ));
+        __m256d likelihood = _mm256_div_pd(numerator, _mm256_add_pd(one, u));
+        likelihood = _mm256_andnot_pd(_mm256_cmp_pd(t, _mm256_set1_pd(EXP_OVERFLOW), _CMP_GT_OQ), likelihood);
+        __m256d sigma = _mm256_sub_pd(one, likelihood);
+        __m256d term = _mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(one, sigma), _mm256_set1_pd(weight)), a);
+        acc = _mm256_add_pd(acc, _mm256_and_pd(term, _mm256_cmp_pd(a, zero, _CMP_NEQ_UQ)));
+    }
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    return(sum + sigmoid_weighted_sum_scalar(ax + i, size - i, ay, weight));
+}
+
+// exp(x) for x in [-708, 0]
+__attribute__((target("avx512f")))
+static inline __m512d exp_avx512(const __m512d &x) {
+    __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_HI), x);
+    r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_LO), r);
+    __m512d p = _mm512_set1_pd(EXP_POLY[0]);
+    for (int k = 1; k < 14; k++) {
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_POLY[k]));
+    }
+    __m512i e = _mm512_cvtepi32_epi64(_mm512_cvtpd_epi32(n));
+    e = _mm512_slli_epi64(_mm512_add_epi64(e, _mm512_set1_epi64(1023)), 52);
+    return(_mm512_mul_pd(p, _mm512_castsi512_pd(e)));
+}
+
+__attribute__((target("avx512f")))
+static double sigmoid_weighted_sum_avx512(const double *ax, const size_t &size, const double &ay, const double &weight) {
+    const __m512d one = _mm512_set1_pd(1.0), zero = _mm512_setzero_pd();
+    __m512d acc = zero;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m512d a = _mm512_loadu_pd(ax + i);
+        __m512d t = _mm512_mul_pd(a, _mm512_set1_pd(ay));
+        __m512d abs_t = _mm512_min_pd(_mm512_set1_pd(EXP_CLAMP), _mm512_abs_pd(t));
+        __m512d u = exp_avx512(_mm512_sub_pd(zero, abs_t));
+        __m512d numerator = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(t, zero, _CMP_GE_OQ), one, u);
+        __m512d likelihood = _mm512_div_pd(numerator, _mm512_add_pd(one, u));
+        likelihood = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(t, _mm512_set1_pd(EXP_OVERFLOW), _CMP_GT_OQ), likelihood, zero);
+        __m512d sigma = _mm512_sub_pd(one, likelihood);
+        __m512d term = _mm512_mul_pd(_mm512_mul_pd(_mm512_sub_pd(one, sigma), _mm512_set1_pd(weight)), a);
+        acc = _mm512_mask_add_pd(acc, _mm512_cmp_pd_mask(a, zero, _CMP_NEQ_UQ), acc, term);
+    }
+    double sum = _mm512_reduce_add_pd(acc);
+    return(sum + sigmoid_weighted_sum_scalar(ax + i, size - i, ay, weight));
+}
+#else
+#define LABYRINTH_SIGMOID_SIMD 0
+#endif
+
+typedef double (*SigmoidKernel)(const double *, const size_t &, const double &, const double &);
+
+// The widest instruction set supported by the CPU, checked once
+static SigmoidKernel sigmoid_kernel(string &isa) {
+#if LABYRINTH_SIGMOID_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        isa = "avx512";
+        return(sigmoid_weighted_sum_avx512);
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        isa = "avx2";
+        return(sigmoid_weighted_sum_avx2);
+    }
+#endif
+    isa = "scalar";
+    return(sigmoid_weighted_sum_scalar);
+}
+
+static string sigmoid_isa_name;
+static const SigmoidKernel sigmoid_dispatch = sigmoid_kernel(sigmoid_isa_name);
+
+double sigmoid_weighted_sum(const double *ax, const size_t &size, const double &ay, const double &weight) {
+    return(sigmoid_dispatch(ax, size, ay, weight));
+}
+
+//' The fused sigmoid kernel of Spread-gram.
+//'
+//' @noRd
+//' @param ax  vector of the activation rates of the neighbors
+//' @param ay  the activation rate of the node
+//' @param weight  the weight of each term, such as loose
+//' @param scalar  boolean if the scalar path is used instead of SIMD
+//' @return  returns sum((1 - sigmoid(ax, ay)) * weight * ax) over the nonzero
+//'   ax, with the name of the instruction set as an attribute
+// [[Rcpp::export]]
+NumericVector sigmoid_sum_(const NumericVector &ax, const double ay, const double weight = 1.0, const bool scalar = false) {
+    NumericVector sum(1);
+    if (scalar) {
+        sum[0] = sigmoid_weighted_sum_scalar(ax.begin(), ax.size(), ay, weight);
+        sum.attr("isa") = "scalar";
+    } else {
+        sum[0] = sigmoid_weighted_sum(ax.begin(), ax.size(), ay, weight);
+        sum.attr("isa") = sigmoid_isa_name;
+    }
+    return(sum);
+}
@@ -37,67 +37,595 @@ template <typename T> double transfer_activation_t(T &graph, const int &y, const
 
 }
 
-// [[Rcpp::plugins("cpp17")]]
-template <typename T> VectorXd activation_rate_t(T &graph, const ArrayXd &strength, const ArrayXd &stm, const double loose, int threads, bool remove_first, bool display_progress) {
-    size_t element = graph.rows();
-    // Build new activation_rate matrix
-    MatrixXd activation_pattern(element, element);
-    
-    int max_threads = 1;
-#ifdef _OPENMP
-    max_threads = omp_get_max_threads();
-    if (threads > 0 && threads <= max_threads) {
-        omp_set_num_threads(threads);
+// The sums of the activation of all neighbors and of the backward neighbors
+// of every node x, one column per seed. The nodes are walked in edge-balanced
+// tasks, and hubs split across tasks are reduced in task order.
+void neighbor_activation_t(const NeighborList &neighbors, const vector<EdgeTask> &tasks, const RowArrayXXd &activation, RowArrayXXd &all_sum, RowArrayXXd &backward_sum) {
+    size_t n = neighbors.n, seeds = activation.cols();
+    all_sum.setZero(n, seeds);
+    backward_sum.setZero(n, seeds);
+    vector<RowArrayXXd> partials(tasks.size());
+
+    auto sum_edges = [&](const size_t &first_edge, const size_t &last_edge, auto all, auto backward) {
+        for (size_t k = first_edge; k < last_edge; k++) {
+            all += activation.row(neighbors.inner[k]);
+            if (neighbors.direction[k] & NEIGHBOR_BACKWARD) {
+                backward += activation.row(neighbors.inner[k]);
+            }
+        }
+    };
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t t = 0; t < tasks.size(); t++) {
+        const EdgeTask &task = tasks[t];
+        if (task.split) {
+            partials[t].setZero(2, seeds);
+            sum_edges(task.first_edge, task.last_edge, partials[t].row(0), partials[t].row(1));
+            continue;
+        }
+        for (size_t x = task.first_node; x < task.last_node; x++) {
+            sum_edges(neighbors.outer[x], neighbors.outer[x + 1], all_sum.row(x), backward_sum.row(x));
+        }
+    }
+
+    for (size_t t = 0; t < tasks.size(); t++) {
+        if (tasks[t].split) {
+            all_sum.row(tasks[t].first_node) += partials[t].row(0);
+            backward_sum.row(tasks[t].first_node) += partials[t].row(1);
+        }
+    }
+}
+
+// Same as above in O(1), given the sums of x from neighbor_activation_t and the
+// direction of the edge between x and y, seen from x
+inline double transfer_activation_t(const double &activation_y, const unsigned char &neighbors_y, const double &all_sum, const double &backward_sum, const double loose) {
+    double numerator = activation_y * loose, denominator = 1.0;
+    if (neighbors_y == 0) {
+        numerator = 0.0;
+    } else if (numerator > 0) {
+        // y -> x: all the neighbors of x are included;
+        // x -> y: only the backward neighbors of x, together with node y
+        denominator = (neighbors_y & NEIGHBOR_BACKWARD) ? all_sum : backward_sum + activation_y;
+    }
+    return(numerator / denominator);
+}
+
+// The outcome of solve_activation_pattern. It is a plain struct rather than a
+// List, since the solver runs inside OpenMP regions
+struct SolverResult {
+    VectorXd activation;
+    int iterations = 0;
+    int max_iter = 0;
+    double error = NAN;
+    bool converged = false;
+    string preconditioner = "ilut";
+    int pushes = 0;
+};
+
+// Solve activation_pattern * x = coefficient_matrix with BiCGSTAB, starting
+// from `guess` if given. ILUT is the preconditioner of choice, but the
+// factorization may break down on singular patterns, in which case it falls
+// back to the diagonal preconditioner.
+SolverResult solve_activation_pattern(const SpMat &activation_pattern, const VectorXd &coefficient_matrix, const double tol, const int max_iter, const VectorXd *guess = nullptr) {
+    SolverResult result;
+    ComputationInfo info = NumericalIssue;
+
+    BiCGSTAB<SpMat, IncompleteLUT<double>> solver;
+    solver.setTolerance(tol);
+    if (max_iter > 0) {
+        solver.setMaxIterations(max_iter);
+    }
+    solver.compute(activation_pattern);
+    if (solver.info() == Success) {
+        result.activation = guess ? VectorXd(solver.solveWithGuess(coefficient_matrix, *guess)) : VectorXd(solver.solve(coefficient_matrix));
+        info = solver.info();
+        result.iterations = int(solver.iterations());
+        result.max_iter = int(solver.maxIterations());
+        result.error = solver.error();
+    }
+
+    if (info == NumericalIssue) {
+        BiCGSTAB<SpMat, DiagonalPreconditioner<double>> fallback;
+        fallback.setTolerance(tol);
+        if (max_iter > 0) {
+            fallback.setMaxIterations(max_iter);
+        }
+        fallback.compute(activation_pattern);
+        result.activation = guess ? VectorXd(fallback.solveWithGuess(coefficient_matrix, *guess)) : VectorXd(fallback.solve(coefficient_matrix));
+        info = fallback.info();
+        result.iterations = int(fallback.iterations());
+        result.max_iter = int(fallback.maxIterations());
+        result.error = fallback.error();
+        result.preconditioner = "diagonal";
+    }
+    result.converged = (info == Success);
+    return(result);
+}
+
+// The sums of neighbor_activation_t() for one seed, taken on demand, so that a
+// repair only reads the neighbors of the rows it touches
+class SeedSums {
+public:
+    SeedSums(const NeighborList &neighbors, const double *activation) : neighbors(neighbors), activation(activation), all_sum(neighbors.n), backward_sum(neighbors.n), known(neighbors.n, false) {}
+
+    inline void get(const size_t &x, double &all, double &backward) {
+        if (!known[x]) {
+            double a = 0.0, b = 0.0;
+            for (size_t k = neighbors.outer[x]; k < neighbors.outer[x + 1]; k++) {
+                a += activation[neighbors.inner[k]];
+                if (neighbors.direction[k] & NEIGHBOR_BACKWARD) {
+                    b += activation[neighbors.inner[k]];
+                }
+            }
+            all_sum[x] = a;
+            backward_sum[x] = b;
+            known[x] = true;
+        }
+        all = all_sum[x];
+        backward = backward_sum[x];
+    }
+
+private:
+    const NeighborList &neighbors;
+    const double *activation;
+    vector<double> all_sum, backward_sum;
+    vector<bool> known;
+};
+
+// The entry of the activation pattern of a seed at row y and the column of the
+// edge k of y, as transfer_block() stores it
+inline double pattern_entry(const NeighborList &neighbors, SeedSums &sums, const double *activation, const size_t &y, const size_t &k, const double loose) {
+    double all, backward;
+    sums.get(neighbors.inner[k], all, backward);
+    return(transfer_activation_t(activation[y], reverse_direction(neighbors.direction[k]), all, backward, loose));
+}
+
+// The rows [first, last) of the activation pattern of a seed, built from its
+// sums. The same entries as build_activation_pattern()
+SparseMatrix<double, RowMajor> seed_activation_rows(const NeighborList &neighbors, SeedSums &sums, const double *activation, const size_t &offset, const size_t &first, const size_t &last, const double loose) {
+    size_t removed_element = neighbors.n - offset;
+    vector<Triplet<double>> triplets;
+    triplets.reserve(neighbors.outer[last + offset] - neighbors.outer[first + offset] + last - first);
+    for (size_t y = first + offset; y < last + offset; y++) {
+        triplets.emplace_back(y - offset - first, y - offset, -1.0);
+        for (size_t k = neighbors.outer[y]; k < neighbors.outer[y + 1]; k++) {
+            size_t neighbor_id = neighbors.inner[k];
+            double entry = neighbor_id >= offset ? pattern_entry(neighbors, sums, activation, y, k, loose) : 0.0;
+            if (entry != 0) {
+                triplets.emplace_back(y - offset - first, neighbor_id - offset, entry);
+            }
+        }
+    }
+    SparseMatrix<double, RowMajor> rows(last - first, removed_element);
+    rows.setFromTriplets(triplets.begin(), triplets.end());
+    return(rows);
+}
+
+// The activation pattern of a seed built from its sums, for a repair that
+// falls back to BiCGSTAB
+SpMat seed_activation_pattern(const NeighborList &neighbors, SeedSums &sums, const double *activation, const size_t &offset, const double loose) {
+    return(SpMat(seed_activation_rows(neighbors, sums, activation, offset, 0, neighbors.n - offset, loose)));
+}
+
+// The push budget of repair_activation_pattern(), in edges read per edge of
+// the rows whose residual the push has touched. Pushing the same rows over and
+// over converges slowly, and BiCGSTAB is faster
+const double REPAIR_FRONTIER = 32.0;
+
+// Update the solution `previous` of an earlier system to the current one of a
+// seed. When the strength, the stm or the edges of a few `changed` nodes
+// change, the entries of a row only change within two hops of them: its own
+// strength and stm, and the sums of its neighbors. The residual b - Ax of the
+// previous solution is taken on those rows, and pushed from there
+// (Gauss-Southwell): the diagonal is -1, so pushing row y solves it for x[y],
+// and moves the change into the residual of the rows of column y. The other
+// rows keep the residual of the previous solve. Rows are pushed until every
+// residual is at most tol * |b| / sqrt(n), which bounds |b - Ax| by tol * |b|
+// as in BiCGSTAB. The system is never built: the entries are computed from
+// the neighbor lists as the push reads them. If the push runs out of budget
+// or does not reach the tolerance, BiCGSTAB finishes from the pushed solution.
+// Without `changed`, every row starts in the frontier.
+SolverResult repair_activation_pattern(const NeighborList &neighbors, const double *activation, const VectorXd &coefficient_matrix, const VectorXd &previous, const vector<int> *changed, const size_t &offset, const double loose, const double tol, const int max_iter) {
+    size_t element = neighbors.n, removed_element = element - offset;
+    double norm = coefficient_matrix.norm();
+    SolverResult result;
+    result.preconditioner = "none";
+    if (norm == 0.0) {
+        result.activation = VectorXd::Zero(removed_element);
+        result.error = 0.0;
+        result.converged = true;
+        return(result);
+    }
+
+    // The rows within two hops of the changed nodes
+    vector<size_t> frontier;
+    vector<bool> in_frontier(element, !changed);
+    if (changed) {
+        for (int node : *changed) {
+            if (!in_frontier[node]) {
+                in_frontier[node] = true;
+                frontier.push_back(node);
+            }
+        }
+        for (int hop = 0; hop < 2; hop++) {
+            size_t last = frontier.size();
+            for (size_t i = 0; i < last; i++) {
+                for (size_t k = neighbors.outer[frontier[i]]; k < neighbors.outer[frontier[i] + 1]; k++) {
+                    if (!in_frontier[neighbors.inner[k]]) {
+                        in_frontier[neighbors.inner[k]] = true;
+                        frontier.push_back(neighbors.inner[k]);
+                    }
+                }
+            }
+        }
     } else {
-        threads = max_threads;
+        frontier.resize(element);
+        std::iota(frontier.begin(), frontier.end(), 0);
     }
-# else
-    threads = 1;
-#endif
-    if (display_progress) {
-        Rprintf("Number of threads: %i, max threads: %i. \n", threads, max_threads);
+
+    SeedSums sums(neighbors, activation);
+    VectorXd x = previous, residual = VectorXd::Zero(removed_element);
+    vector<size_t> touched;
+    vector<bool> is_touched(removed_element, false), queued(removed_element, false);
+    auto row_residual = [&](const size_t &y) {
+        double ax = -x[y - offset];
+        for (size_t k = neighbors.outer[y]; k < neighbors.outer[y + 1]; k++) {
+            if (size_t(neighbors.inner[k]) >= offset) {
+                ax += pattern_entry(neighbors, sums, activation, y, k, loose) * x[neighbors.inner[k] - offset];
+            }
+        }
+        return(coefficient_matrix[y - offset] - ax);
+    };
+
+    double epsilon = tol * norm / std::sqrt(double(removed_element)), frontier_edges = 0.0, work = 0.0;
+    std::deque<size_t> queue;
+    for (size_t y : frontier) {
+        if (y < offset) {
+            continue;
+        }
+        size_t row = y - offset;
+        residual[row] = row_residual(y);
+        is_touched[row] = true;
+        touched.push_back(row);
+        frontier_edges += double(neighbors.degree(y)) + 1.0;
+        if (std::abs(residual[row]) > epsilon) {
+            queued[row] = true;
+            queue.push_back(row);
+        }
     }
 
-    // Iterate over all nodes
-    Progress p(element, display_progress);
-    #pragma omp parallel for schedule(dynamic, 1)
-    for (int y = 0; y < element; y++) {
-        // Find all neighbors ID in the graph
-        ArrayXi neighbors = get_neighbors_t(graph, y, 0);
-        
-        if (!Progress::check_abort()) {
-            p.increment();
-            for (int neighbor_id = 0; neighbor_id < element; neighbor_id++) {
-                if (neighbors[neighbor_id]) {
-                    activation_pattern.coeffRef(y, neighbor_id) = transfer_activation_t(graph, y, neighbor_id, strength, loose);
+    while (!queue.empty() && work < REPAIR_FRONTIER * frontier_edges) {
+        size_t row = queue.front(), y = row + offset;
+        queue.pop_front();
+        queued[row] = false;
+        double step = -residual[row], all, backward;
+        x[row] += step;
+        residual[row] = 0.0;
+        result.pushes++;
+        // Column y holds the entries of the rows z of its neighbors, whose
+        // edge to y is seen as the reverse of the edge k of y
+        sums.get(y, all, backward);
+        for (size_t k = neighbors.outer[y]; k < neighbors.outer[y + 1]; k++) {
+            size_t z = neighbors.inner[k];
+            if (z < offset) {
+                continue;
+            }
+            double entry = transfer_activation_t(activation[z], neighbors.direction[k], all, backward, loose);
+            if (entry == 0.0) {
+                continue;
+            }
+            size_t other = z - offset;
+            residual[other] -= entry * step;
+            if (!is_touched[other]) {
+                is_touched[other] = true;
+                touched.push_back(other);
+                frontier_edges += double(neighbors.degree(z)) + 1.0;
+            }
+            if (!queued[other] && std::abs(residual[other]) > epsilon) {
+                queued[other] = true;
+                queue.push_back(other);
+            }
+        }
+        work += double(neighbors.degree(y)) + 1.0;
+    }
+
+    // The running residual drifts by rounding, so the error of the touched
+    // rows is measured anew
+    double squares = 0.0;
+    for (size_t row : touched) {
+        double r = row_residual(row + offset);
+        squares += r * r;
+    }
+    result.error = std::sqrt(squares) / norm;
+    if (result.error <= tol) {
+        result.activation = x;
+        result.converged = true;
+        return(result);
+    }
+    int pushes = result.pushes;
+    result = solve_activation_pattern(seed_activation_pattern(neighbors, sums, activation, offset, loose), coefficient_matrix, tol, max_iter, &x);
+    result.pushes = pushes;
+    return(result);
+}
+
+// The activation transferred along every edge, one column per seed. The
+// activation pattern shares the nonzero pattern of the graph, so it is stored
+// by edge alongside the neighbor lists. Every edge is independent, so a task
+// only clips the edges of its nodes to its own range
+void transfer_block(const NeighborList &neighbors, const vector<EdgeTask> &tasks, const RowArrayXXd &activation, const RowArrayXXd &all_sum, const RowArrayXXd &backward_sum, const double loose, RowArrayXXd &transferred, KernelMonitor &monitor, KernelProfile &profile) {
+    size_t block_seeds = activation.cols();
+    transferred.resize(neighbors.edges(), block_seeds);
+    #pragma omp parallel
+    {
+        double begin = profile.now();
+        #pragma omp for schedule(dynamic, 1) nowait
+        for (size_t t = 0; t < tasks.size(); t++) {
+            const EdgeTask &task = tasks[t];
+            if (monitor.aborted()) {
+                continue;
+            }
+            for (size_t y = task.first_node; y < task.last_node; y++) {
+                size_t first_edge = std::max(neighbors.outer[y], task.first_edge);
+                size_t last_edge = std::min(neighbors.outer[y + 1], task.last_edge);
+                for (size_t k = first_edge; k < last_edge; k++) {
+                    int x = neighbors.inner[k];
+                    unsigned char neighbors_y = reverse_direction(neighbors.direction[k]);
+                    for (size_t seed = 0; seed < block_seeds; seed++) {
+                        transferred(k, seed) = transfer_activation_t(activation(y, seed), neighbors_y, all_sum(x, seed), backward_sum(x, seed), loose);
+                    }
+                }
+                if (last_edge == neighbors.outer[y + 1]) {
+                    monitor.increment();
                 }
             }
         }
+        profile.busy(begin);
     }
-    
-    if (display_progress) {
-        Rprintf("Solving activation patterns...\n");
-    }
-    
-    // Build two matrices
-    VectorXd coefficient_matrix = strength * stm * (-1.0);
-    #pragma omp parallel for
-    for (int i = 0; i < element; i++) {
-        activation_pattern.diagonal()[i] = -1.0;
-    }
-    
-    if (remove_first) {
-        size_t removed_element = element - 1;
-        activation_pattern = activation_pattern.rightCols(removed_element).bottomRows(removed_element);
-        VectorXd shrinked_coefficient_matrix = coefficient_matrix.bottomRows(removed_element);
-        coefficient_matrix.resize(0);
-        coefficient_matrix = shrinked_coefficient_matrix;
-    }
-    BiCGSTAB<MatrixXd> solver;
-    solver.compute(activation_pattern);
-    VectorXd activated = solver.solve(coefficient_matrix);
+    profile.count("edges", double(neighbors.edges()) * block_seeds);
+    profile.count("bytes", double(sizeof(double) * transferred.size()));
+}
 
-    return(activated);
+// Build the activation pattern of one seed from the transferred activation on
+// the edges. The first node is left out when offset is 1
+SpMat build_activation_pattern(const NeighborList &neighbors, const RowArrayXXd &transferred, const size_t &seed, const size_t &offset) {
+    size_t element = neighbors.n, removed_element = element - offset;
+    vector<Triplet<double>> triplets;
+    triplets.reserve(neighbors.edges() + removed_element);
+    for (size_t y = offset; y < element; y++) {
+        triplets.emplace_back(y - offset, y - offset, -1.0);
+        for (size_t k = neighbors.outer[y]; k < neighbors.outer[y + 1]; k++) {
+            size_t neighbor_id = neighbors.inner[k];
+            if (neighbor_id >= offset && transferred(k, seed) != 0) {
+                triplets.emplace_back(y - offset, neighbor_id - offset, transferred(k, seed));
+            }
+        }
+    }
+    SpMat activation_pattern(removed_element, removed_element);
+    activation_pattern.setFromTriplets(triplets.begin(), triplets.end());
+    return(activation_pattern);
+}
+
+// The graph and the linear systems of activation_rate_t(), prepared in the
+// session: the neighbor lists are copied out of the R objects, so that the
+// systems may be solved in the background. In a reordered graph the systems
+// are built and solved in the permuted order, which keeps the first node in
+// front for remove_first, and the activation is mapped back by `kept`
+struct ActivationProblem {
+    NeighborList neighbors;
+    vector<EdgeTask> tasks;
+    vector<int> kept;
+    MatrixXd strength, stm, previous;
+    // The nodes changed since `previous`, one list per seed or one shared
+    // list, or none if unknown
+    vector<vector<int>> changed;
+    size_t offset = 0;
+};
+
+// The outcome of activation_rate_t(), converted to a List by
+// activation_rate_list()
+struct ActivationResult {
+    MatrixXd activation;
+    vector<SolverResult> solved;
+    double tol = 0.0;
+};
+
+// The changed nodes of the seeds from R, as (0-based) nodes of the graph
+vector<vector<int>> changed_nodes(const Nullable<List> &changed, const Index &n) {
+    vector<vector<int>> nodes;
+    if (changed.isNull()) {
+        return(nodes);
+    }
+    List lists(changed.get());
+    for (R_xlen_t seed = 0; seed < lists.size(); seed++) {
+        nodes.push_back(as<vector<int>>(lists[seed]));
+        for (int node : nodes.back()) {
+            if (node < 0 || node >= n) {
+                stop("The changed nodes are out of range.");
+            }
+        }
+    }
+    return(nodes);
+}
+
+template <typename T> ActivationProblem activation_rate_problem(T &graph, const MatrixXd &initial_strength, const MatrixXd &initial_stm, bool remove_first, const std::string &reorder, const MatrixXd &initial_previous, const vector<vector<int>> &changed, KernelProfile &profile) {
+    ActivationProblem problem;
+    profile.start("neighbors");
+    problem.neighbors = build_neighbors(graph);
+    vector<int> order;
+    if (reorder != "none") {
+        profile.start("reorder");
+        order = graph_order(problem.neighbors, reorder, remove_first);
+        problem.neighbors = permute_neighbors(problem.neighbors, order);
+        profile.start("neighbors");
+    }
+    problem.strength = order.empty() ? initial_strength : permute_rows(initial_strength, order);
+    problem.stm = order.empty() ? initial_stm : permute_rows(initial_stm, order);
+    problem.tasks = partition_edges(problem.neighbors);
+    profile.count("bytes", double(problem.neighbors.bytes() + sizeof(EdgeTask) * problem.tasks.size()));
+    problem.offset = remove_first ? 1 : 0;
+    // The activation leaves out the first node, so its order is the order of
+    // the other nodes
+    if (!order.empty()) {
+        problem.kept.assign(order.begin() + problem.offset, order.end());
+        for (int &node : problem.kept) {
+            node -= int(problem.offset);
+        }
+    }
+    // An earlier activation, if any, is repaired instead of solved anew
+    problem.previous = (problem.kept.empty() || initial_previous.size() == 0) ? initial_previous : permute_rows(initial_previous, problem.kept);
+    problem.changed = changed;
+    if (changed.size() > 1 && changed.size() != size_t(initial_strength.cols())) {
+        stop("The changed nodes must have one element per seed or one shared element.");
+    }
+    if (!order.empty()) {
+        vector<int> position(order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            position[order[i]] = int(i);
+        }
+        for (vector<int> &nodes : problem.changed) {
+            for (int &node : nodes) {
+                node = position[node];
+            }
+        }
+    }
+    return(problem);
+}
+
+// Seeds are handled in blocks: the neighbor lists are walked once per block,
+// and the transferred activation of a block (edges x seeds) is kept within a
+// few dozen megabytes
+inline size_t activation_block(const NeighborList &neighbors) {
+    return(std::clamp<size_t>((size_t(1) << 22) / std::max<size_t>(neighbors.edges(), 1), 1, 16));
+}
+
+// Solve the systems block by block. Once aborted, the remaining seeds are
+// left unsolved, with NaN activation, instead of running their solves
+ActivationResult activation_rate_run(const ActivationProblem &problem, const double loose, double tol, int max_iter, KernelProfile &profile, KernelMonitor &monitor) {
+    const NeighborList &neighbors = problem.neighbors;
+    const vector<EdgeTask> &tasks = problem.tasks;
+    const MatrixXd &strength = problem.strength, &stm = problem.stm, &previous = problem.previous;
+    size_t element = neighbors.n, seeds = strength.cols();
+    size_t offset = problem.offset, removed_element = element - offset;
+
+    size_t block = activation_block(neighbors);
+    ActivationResult result;
+    result.tol = tol;
+    result.activation = MatrixXd::Constant(removed_element, seeds, NAN);
+    result.solved.resize(seeds);
+    MatrixXd &activated = result.activation;
+    vector<SolverResult> &solved = result.solved;
+
+    for (size_t first_seed = 0; first_seed < seeds && !monitor.aborted(); first_seed += block) {
+        size_t block_seeds = std::min(block, seeds - first_seed);
+        // A repair reads the entries of the rows it touches on its own
+        RowArrayXXd transferred;
+        if (previous.size() == 0) {
+            RowArrayXXd activation = strength.middleCols(first_seed, block_seeds).array();
+            RowArrayXXd all_sum, backward_sum;
+            profile.start("transfer");
+            neighbor_activation_t(neighbors, tasks, activation, all_sum, backward_sum);
+            transfer_block(neighbors, tasks, activation, all_sum, backward_sum, loose, transferred, monitor, profile);
+        }
+
+        // Every seed owns its linear system, and the systems are independent
+        profile.start("solve");
+        #pragma omp parallel
+        {
+            double begin = profile.now();
+            #pragma omp for schedule(dynamic, 1) nowait
+            for (size_t seed = 0; seed < block_seeds; seed++) {
+                if (monitor.aborted()) {
+                    continue;
+                }
+                size_t column = first_seed + seed;
+                VectorXd coefficient_matrix = (strength.col(column).array() * stm.col(stm.cols() > 1 ? column : 0).array() * (-1.0)).matrix().tail(removed_element);
+                if (previous.size() > 0) {
+                    const vector<int> *changed = problem.changed.empty() ? nullptr : &problem.changed[problem.changed.size() > 1 ? column : 0];
+                    solved[column] = repair_activation_pattern(neighbors, strength.col(column).data(), coefficient_matrix, previous.col(previous.cols() > 1 ? column : 0), changed, offset, loose, tol, max_iter);
+                } else {
+                    SpMat activation_pattern = build_activation_pattern(neighbors, transferred, seed, offset);
+                    solved[column] = solve_activation_pattern(activation_pattern, coefficient_matrix, tol, max_iter);
+                }
+                activated.col(column) = solved[column].activation;
+            }
+            profile.busy(begin);
+        }
+        if (previous.size() > 0) {
+            monitor.increment(element);
+        }
+        if (monitor.partial_requested()) {
+            monitor.publish_partial(problem.kept.empty() ? activated : restore_rows(activated, problem.kept));
+        }
+    }
+    profile.stop();
+
+    if (!problem.kept.empty()) {
+        activated = restore_rows(activated, problem.kept);
+    }
+    for (const SolverResult &seed : solved) {
+        profile.count("iterations", double(seed.iterations));
+        profile.count("pushes", double(seed.pushes));
+    }
+    profile.count("bytes", double(sizeof(double) * activated.size()));
+    return(result);
+}
+
+List activation_rate_list(const ActivationResult &result, bool display_progress) {
+    size_t seeds = result.solved.size();
+    IntegerVector iterations(seeds), max_iterations(seeds), pushes(seeds);
+    NumericVector error(seeds);
+    LogicalVector converged(seeds);
+    CharacterVector preconditioner(seeds);
+    for (size_t seed = 0; seed < seeds; seed++) {
+        const SolverResult &solved = result.solved[seed];
+        iterations[seed] = solved.iterations;
+        max_iterations[seed] = solved.max_iter;
+        error[seed] = solved.error;
+        converged[seed] = solved.converged;
+        preconditioner[seed] = solved.preconditioner;
+        pushes[seed] = solved.pushes;
+        if (display_progress) {
+            Rprintf("Seed #%i solved in %i pushes and %i iterations, estimated error: %g.\n", int(seed + 1), solved.pushes, solved.iterations, solved.error);
+        }
+    }
+    return(List::create(Named("activation") = result.activation,
+                        Named("iterations") = iterations,
+                        Named("error") = error,
+                        Named("tolerance") = result.tol,
+                        Named("max_iter") = max_iterations,
+                        Named("converged") = converged,
+                        Named("preconditioner") = preconditioner,
+                        Named("pushes") = pushes));
+}
+
+// Solve the systems, or submit them as a background job on `async` workers of
+// the job pool, see jobs.cpp
+// [[Rcpp::plugins("cpp17")]]
+template <typename T> SEXP activation_rate_t(T &graph, const MatrixXd &initial_strength, const MatrixXd &initial_stm, const double loose, int threads, bool remove_first, double tol, int max_iter, bool display_progress, const std::string &reorder, const MatrixXd &initial_previous, const vector<vector<int>> &changed, bool profiled, int async) {
+    ThreadScope scope(threads);
+    auto profile = std::make_shared<KernelProfile>(profiled);
+    auto problem = std::make_shared<ActivationProblem>(activation_rate_problem(graph, initial_strength, initial_stm, remove_first, reorder, initial_previous, changed, *profile));
+    size_t element = problem->neighbors.n, seeds = initial_strength.cols();
+    size_t block = activation_block(problem->neighbors);
+    size_t total = element * ((seeds + block - 1) / block);
+    if (async > 0) {
+        auto result = std::make_shared<ActivationResult>();
+        auto job = std::make_shared<Job>(threads);
+        job->work = [=](Job &job) {
+            KernelMonitor monitor(total, false, &job);
+            *result = activation_rate_run(*problem, loose, tol, max_iter, *profile, monitor);
+        };
+        job->collect = [=]() {
+            return(wrap(with_profile(activation_rate_list(*result, false), *profile)));
+        };
+        return(submit_job(job, async));
+    }
+
+    if (display_progress) {
+        Rprintf("Number of threads: %i, max threads: %i. \n", scope.threads(), scope.available());
+    }
+    KernelMonitor monitor(total, display_progress);
+    return(with_profile(activation_rate_list(activation_rate_run(*problem, loose, tol, max_iter, *profile, monitor), display_progress), *profile));
 }
 
 //' Calculate the received activation in Spreading Activation (f)
@@ -204,12 +732,14 @@ double transfer_activation_d(MMatrixXd &graph, const int &y, const int &x, const
 //'   relations between two nodes. The diagonal of the matrix should be 0, as
 //'   there are no self-edges in the graph.
 //'
-//' @param strength A vector containing the *relative strength* of connections
+//' @param strength A matrix containing the *relative strength* of connections
 //'   for each node in the graph, which is the same as the last time activation
-//'   rates of all nodes. The sequence is the same as the matrix.
+//'   rates of all nodes, one column per seed. The sequence is the same as the
+//'   matrix.
 //'
-//' @param stm A binary vector which indicating whether the node is activated, or
-//'   in the short-term memory
+//' @param stm A binary matrix which indicating whether the node is activated,
+//'   or in the short-term memory. It has either one column shared by all seeds
+//'   or one column per seed.
 //'
 //' @param loose A scalar numeric between 0 and 1 that determines the loose (or
 //'   weight) in the calculation process.
@@ -217,7 +747,34 @@ double transfer_activation_d(MMatrixXd &graph, const int &y, const int &x, const
 //' @param remove_first A logical value indicating whether or not to exclude the
 //'   first node from the calculation
 //'
-//' @return A vector containing the activation rate for each node in the graph
+//' @param tol The tolerance of the relative residual in the BiCGSTAB solver.
+//'
+//' @param max_iter The maximum iterations of the BiCGSTAB solver. 0 means twice
+//'   the number of nodes.
+//'
+//' @param reorder The order of the nodes the systems are built in: none, rcm,
+//'   degree or community. The activation is always in the order of the graph.
+//'
+//' @param previous The activation of an earlier call, one column per seed or
+//'   one shared column, which is repaired from its residual instead of solving
+//'   the systems anew. NULL solves anew.
+//'
+//' @param changed NULL, or a list of the (0-based) nodes whose strength, stm
+//'   or edges changed since `previous`, one element per seed or one shared one.
+//'   The repair starts from the rows around them. NULL starts from every row.
+//'
+//' @param profile Whether to attach the profile of the call as the `profile`
+//'   attribute.
+//'
+//' @param async 0 to run in the session, or the number of workers of the job
+//'   pool to solve the systems on in the background.
+//'
+//' @return A list containing the activation rate for each node in the graph
+//'   and each seed (`activation`), and for each seed the iterations and the
+//'   estimated error of the solver, the tolerance, the maximum iterations,
+//'   whether the solver converges, the preconditioner being used and the
+//'   pushes of the repair, or the external pointer of the job if `async` is
+//'   positive.
 //'
 //' @examples
 //' library(magrittr)
@@ -247,8 +804,8 @@ double transfer_activation_d(MMatrixXd &graph, const int &y, const int &x, const
 //' 
 // [[Rcpp::plugins("cpp17")]]
 // [[Rcpp::export]]
-VectorXd activation_rate_s(MSpMat &graph, const ArrayXd &strength, const ArrayXd &stm, const double loose = 1.0, int threads = 0, bool remove_first = false, bool display_progress = true) {
-    return(activation_rate_t(graph, strength, stm, loose, threads, remove_first, display_progress));
+SEXP activation_rate_s(MSpMat &graph, const MatrixXd &strength, const MatrixXd &stm, const double loose = 1.0, int threads = 0, bool remove_first = false, double tol = 1e-12, int max_iter = 0, bool display_progress = true, std::string reorder = "none", Nullable<NumericMatrix> previous = R_NilValue, Nullable<List> changed = R_NilValue, bool profile = false, int async = 0) {
+    return(activation_rate_t(graph, strength, stm, loose, threads, remove_first, tol, max_iter, display_progress, reorder, optional_matrix(previous), changed_nodes(changed, graph.rows()), profile, async));
 }
 
 //' Calculate the next-time ACT activation rate
@@ -272,12 +829,14 @@ VectorXd activation_rate_s(MSpMat &graph, const ArrayXd &strength, const ArrayXd
 //'   relations between two nodes. The diagonal of the matrix should be 0, as
 //'   there are no self-edges in the graph.
 //'
-//' @param strength A vector containing the *relative strength* of connections
+//' @param strength A matrix containing the *relative strength* of connections
 //'   for each node in the graph, which is the same as the last time activation
-//'   rates of all nodes. The sequence is the same as the matrix.
+//'   rates of all nodes, one column per seed. The sequence is the same as the
+//'   matrix.
 //'
-//' @param stm A binary vector which indicating whether the node is activated, or
-//'   in the short-term memory
+//' @param stm A binary matrix which indicating whether the node is activated,
+//'   or in the short-term memory. It has either one column shared by all seeds
+//'   or one column per seed.
 //'
 //' @param loose A scalar numeric between 0 and 1 that determines the loose (or
 //'   weight) in the calculation process.
@@ -285,7 +844,34 @@ VectorXd activation_rate_s(MSpMat &graph, const ArrayXd &strength, const ArrayXd
 //' @param remove_first A logical value indicating whether or not to exclude the
 //'   first node from the calculation
 //'
-//' @return A vector containing the activation rate for each node in the graph
+//' @param tol The tolerance of the relative residual in the BiCGSTAB solver.
+//'
+//' @param max_iter The maximum iterations of the BiCGSTAB solver. 0 means twice
+//'   the number of nodes.
+//'
+//' @param reorder The order of the nodes the systems are built in: none, rcm,
+//'   degree or community. The activation is always in the order of the graph.
+//'
+//' @param previous The activation of an earlier call, one column per seed or
+//'   one shared column, which is repaired from its residual instead of solving
+//'   the systems anew. NULL solves anew.
+//'
+//' @param changed NULL, or a list of the (0-based) nodes whose strength, stm
+//'   or edges changed since `previous`, one element per seed or one shared one.
+//'   The repair starts from the rows around them. NULL starts from every row.
+//'
+//' @param profile Whether to attach the profile of the call as the `profile`
+//'   attribute.
+//'
+//' @param async 0 to run in the session, or the number of workers of the job
+//'   pool to solve the systems on in the background.
+//'
+//' @return A list containing the activation rate for each node in the graph
+//'   and each seed (`activation`), and for each seed the iterations and the
+//'   estimated error of the solver, the tolerance, the maximum iterations,
+//'   whether the solver converges, the preconditioner being used and the
+//'   pushes of the repair, or the external pointer of the job if `async` is
+//'   positive.
 //'
 //' @examples
 //' library(magrittr)
@@ -314,6 +900,346 @@ VectorXd activation_rate_s(MSpMat &graph, const ArrayXd &strength, const ArrayXd
 //'   loose = 0.8, remove_first = TRUE)
 // [[Rcpp::plugins("cpp17")]]
 // [[Rcpp::export]]
-VectorXd activation_rate_d(MMatrixXd &graph, const ArrayXd &strength, const ArrayXd &stm, const double loose = 1.0, int threads = 0, bool remove_first = false, bool display_progress = true) {
-    return(activation_rate_t(graph, strength, stm, loose, threads, remove_first, display_progress));
+SEXP activation_rate_d(MMatrixXd &graph, const MatrixXd &strength, const MatrixXd &stm, const double loose = 1.0, int threads = 0, bool remove_first = false, double tol = 1e-12, int max_iter = 0, bool display_progress = true, std::string reorder = "none", Nullable<NumericMatrix> previous = R_NilValue, Nullable<List> changed = R_NilValue, bool profile = false, int async = 0) {
+    return(activation_rate_t(graph, strength, stm, loose, threads, remove_first, tol, max_iter, display_progress, reorder, optional_matrix(previous), changed_nodes(changed, graph.rows()), profile, async));
+}
+
+//' Compute the activation rates on the graph of a graph store
+//'
+//' @description
+//' The same as activation_rate_s(), on the graph of a graph store, which is
+//'   read from the mapped file without copying.
+//'
+//' @param store The external pointer of a graph store.
+//'
+//' @noRd
+// [[Rcpp::plugins("cpp17")]]
+// [[Rcpp::export]]
+SEXP activation_rate_m(SEXP store, const MatrixXd &strength, const MatrixXd &stm, const double loose = 1.0, int threads = 0, bool remove_first = false, double tol = 1e-12, int max_iter = 0, bool display_progress = true, std::string reorder = "none", Nullable<NumericMatrix> previous = R_NilValue, Nullable<List> changed = R_NilValue, bool profile = false, int async = 0) {
+    MSpMat graph = graph_store_matrix(store, 0);
+    return(activation_rate_t(graph, strength, stm, loose, threads, remove_first, tol, max_iter, display_progress, reorder, optional_matrix(previous), changed_nodes(changed, graph.rows()), profile, async));
+}
+
+// The activation rate partitioned over processes forked from the session, see
+// partitioned_run() in R and the partitioned walk in random_walk.cpp. Every
+// process owns a block of rows of the systems, in whole chunks with about the
+// same number of edges (see partition_rows()), and builds them from the
+// neighbor lists of the problem, which the workers inherit. Each system is
+// solved by BiCGSTAB as in Eigen, with the dot products reduced over the
+// chunks of rows in chunk order, and the two vectors multiplied by the matrix
+// in each iteration exchanged in the SharedSegment. ILUT factors the whole
+// matrix at once, so a process only factors its diagonal block: the
+// preconditioner is block Jacobi, whose iterations and rounding differ from
+// those of one process. The solution meets the same tolerance, and is the
+// same with any number of threads.
+
+// The state of the solves, which rank 0 writes between two barriers and the
+// others read after the second
+struct ActivationState {
+    Index n, seeds;
+    int stop;
+};
+
+// The reductions of an iteration, each in slots of its own, so that a process
+// never overwrites the sums that another has yet to read
+enum ActivationSlot { SLOT_START, SLOT_RESIDUAL, SLOT_RESTART, SLOT_ALPHA, SLOT_OMEGA, ACTIVATION_SLOTS };
+
+// The offsets of the arrays of the solves in their segment: the bounds of the
+// rows of every process, the state, whether the ILUT of every process broke
+// down, the sums of every slot (two columns per chunk), and the solution and
+// the two vectors multiplied by the matrix in an iteration
+struct ActivationLayout {
+    size_t bounds, state, failed, slots, x, y, z, bytes;
+
+    ActivationLayout(const Index &n, const int &processes) {
+        auto align = [](const size_t &offset) {
+            return((offset + 63) / 64 * 64);
+        };
+        const size_t vector = sizeof(double) * n;
+        bounds = 0;
+        state = align(sizeof(Index) * (processes + 1));
+        failed = align(state + sizeof(ActivationState));
+        slots = align(failed + sizeof(int) * processes);
+        x = align(slots + sizeof(double) * ACTIVATION_SLOTS * partition_chunks(n) * 2);
+        y = align(x + vector);
+        z = align(y + vector);
+        bytes = z + vector;
+    }
+};
+
+// The product of the rows of a process with a vector of all rows, on
+// `threads` threads, a chunk of rows at a time
+inline void rows_product(const SparseMatrix<double, RowMajor> &rows, const double *vector, VectorXd &product, const int &threads) {
+    Map<const VectorXd> all(vector, rows.cols());
+    product.resize(rows.rows());
+    TaskQueue queue(partition_chunks(rows.rows()));
+    parallel_region(threads, [&]() {
+        for (size_t chunk; queue.take(chunk);) {
+            const Index first = Index(chunk) * PARTITION_CHUNK, size = std::min(PARTITION_CHUNK, rows.rows() - first);
+            product.segment(first, size).noalias() = rows.middleRows(first, size) * all;
+        }
+    });
+}
+
+// Run the part `rank` of the solves on `threads` threads. Rank 0 fills the
+// result, whose activation stays NaN for the seeds left unsolved when the
+// session is interrupted
+void activation_partition_run(SharedSegment *segment, const int &rank, const ActivationProblem &problem, const double &loose, const double &tol, const int &max_iter, const int &threads, ActivationResult &result) {
+    const NeighborList &neighbors = problem.neighbors;
+    const MatrixXd &strength = problem.strength, &stm = problem.stm;
+    const size_t offset = problem.offset;
+    const Index n = neighbors.n - offset, chunks = partition_chunks(n);
+    ActivationLayout layout(n, segment->processes());
+    ActivationState *state = segment->array<ActivationState>(layout.state);
+    const Index *bounds = segment->array<Index>(layout.bounds);
+    const Index first = bounds[rank], last = bounds[rank + 1], rows = last - first;
+    int *failed = segment->array<int>(layout.failed);
+    double *x_all = segment->array<double>(layout.x), *y_all = segment->array<double>(layout.y), *z_all = segment->array<double>(layout.z);
+    const Index max_iterations = max_iter > 0 ? max_iter : 2 * n;
+    const double eps2 = NumTraits<double>::epsilon() * NumTraits<double>::epsilon();
+
+    // The sums of one or two products of the rows of this process over its
+    // chunks, and their totals over every process once all have written them
+    auto sums = [&](const ActivationSlot &slot) {
+        return(segment->array<double>(layout.slots) + slot * chunks * 2);
+    };
+    auto reduce = [&](const ActivationSlot &slot, const VectorXd &a, const VectorXd &b, const VectorXd *c, const VectorXd *d) {
+        chunk_sums(
+            [&](const Index &row, const Index &column) {
+                return(column == 0 ? a[row - first] * b[row - first] : (*c)[row - first] * (*d)[row - first]);
+            },
+            first, last, c ? 2 : 1, sums(slot), Index(2));
+        segment->wait(rank);
+        return(add_chunks(sums(slot), chunks, c ? 2 : 1, 2));
+    };
+
+    try {
+        for (Index seed = 0; seed < state->seeds; seed++) {
+            // The rows of the system, and the preconditioner of its diagonal
+            // block
+            const double *activation = strength.col(seed).data();
+            SeedSums seed_sums(neighbors, activation);
+            SparseMatrix<double, RowMajor> system = seed_activation_rows(neighbors, seed_sums, activation, offset, first, last, loose);
+            VectorXd b = (strength.col(seed).array() * stm.col(stm.cols() > 1 ? seed : 0).array() * (-1.0)).matrix().segment(first + offset, rows);
+            SpMat diagonal = system.middleCols(first, rows);
+            IncompleteLUT<double> ilut;
+            if (rows > 0) {
+                ilut.compute(diagonal);
+            }
+            failed[rank] = rows > 0 && ilut.info() != Success;
+            VectorXd inverse_diagonal = VectorXd::Ones(rows);
+            for (Index i = 0; i < rows; i++) {
+                if (diagonal.coeff(i, i) != 0) {
+                    inverse_diagonal[i] = 1.0 / diagonal.coeff(i, i);
+                }
+            }
+            std::fill(x_all + first, x_all + last, 0.0);
+            const double rhs_sqnorm = reduce(SLOT_START, b, b, nullptr, nullptr)[0];
+
+            // Every process falls back to the diagonal preconditioner if the
+            // ILUT of any breaks down, as solve_activation_pattern() does
+            const bool fallback = std::any_of(failed, failed + segment->processes(), [](const int &f) {
+                return(f != 0);
+            });
+            auto precondition = [&](const VectorXd &v) {
+                return((fallback || rows == 0) ? VectorXd(inverse_diagonal.cwiseProduct(v)) : VectorXd(ilut.solve(v)));
+            };
+            SolverResult solved;
+            solved.max_iter = int(max_iterations);
+            solved.preconditioner = fallback ? "diagonal" : "ilut";
+            solved.iterations = int(max_iterations);
+            solved.error = tol;
+
+            // BiCGSTAB from x = 0, as bicgstab() in Eigen
+            if (rhs_sqnorm != 0) {
+                VectorXd r = b, r0 = r, x = VectorXd::Zero(rows), v = VectorXd::Zero(rows), p = VectorXd::Zero(rows);
+                VectorXd y, z, s, t;
+                double r0_sqnorm = rhs_sqnorm, rho = 1.0, alpha = 1.0, w = 1.0, r_sqnorm = rhs_sqnorm;
+                const double tol2 = tol * tol * rhs_sqnorm;
+                Index i = 0, restarts = 0;
+                while (true) {
+                    RowVectorXd residual = reduce(SLOT_RESIDUAL, r, r, &r0, &r);
+                    r_sqnorm = residual[0];
+                    if (!(r_sqnorm > tol2 && i < max_iterations)) {
+                        break;
+                    }
+                    double rho_old = rho;
+                    rho = residual[1];
+                    if (std::abs(rho) < eps2 * r0_sqnorm) {
+                        // Restart with a new r0
+                        VectorXd product;
+                        rows_product(system, x_all, product, threads);
+                        r = b - product;
+                        r0 = r;
+                        rho = r0_sqnorm = reduce(SLOT_RESTART, r, r, nullptr, nullptr)[0];
+                        if (restarts++ == 0) {
+                            i = 0;
+                        }
+                    }
+                    double beta = (rho / rho_old) * (alpha / w);
+                    p = r + beta * (p - w * v);
+
+                    y = precondition(p);
+                    std::copy(y.data(), y.data() + rows, y_all + first);
+                    segment->wait(rank);
+                    rows_product(system, y_all, v, threads);
+                    alpha = rho / reduce(SLOT_ALPHA, r0, v, nullptr, nullptr)[0];
+                    s = r - alpha * v;
+
+                    z = precondition(s);
+                    std::copy(z.data(), z.data() + rows, z_all + first);
+                    segment->wait(rank);
+                    rows_product(system, z_all, t, threads);
+                    RowVectorXd omega = reduce(SLOT_OMEGA, t, t, &t, &s);
+                    w = omega[0] > 0 ? omega[1] / omega[0] : 0.0;
+
+                    x += alpha * y + w * z;
+                    std::copy(x.data(), x.data() + rows, x_all + first);
+                    r = s - w * t;
+                    ++i;
+                }
+                solved.error = std::sqrt(r_sqnorm / rhs_sqnorm);
+                solved.iterations = int(i);
+            }
+            solved.converged = solved.error <= tol;
+
+            // Every process has written its rows of x before the last barrier
+            if (rank == 0) {
+                solved.activation = Map<const VectorXd>(x_all, n);
+                result.activation.col(seed) = solved.activation;
+                result.solved[seed] = solved;
+                state->stop = Progress::check_abort();
+            }
+            segment->wait(rank);
+            if (state->stop) {
+                break;
+            }
+        }
+    } catch (...) {
+        segment->fail();
+        throw;
+    }
+}
+
+template <typename T> SEXP activation_rate_problem_t(T &graph, const MatrixXd &strength, const MatrixXd &stm, bool remove_first, const std::string &reorder, int threads) {
+    ThreadScope scope(threads);
+    KernelProfile profile(false);
+    return(XPtr<ActivationProblem>(new ActivationProblem(activation_rate_problem(graph, strength, stm, remove_first, reorder, MatrixXd(), vector<vector<int>>(), profile)), true));
+}
+
+//' Prepare a partitioned solve of the activation rates
+//'
+//' @noRd
+//' @param graph  the graph
+//' @param strength  the strength of the nodes, one column per seed
+//' @param stm  the stm of the nodes, one column per seed or one shared column
+//' @param remove_first  whether the first node is left out
+//' @param reorder  the order of the nodes the systems are built in
+//' @param threads  the parallel threads, 0 for the default
+//' @return  the external pointer of the problem, which the processes forked
+//'   afterwards share
+// [[Rcpp::export]]
+SEXP activation_rate_problem_s(MSpMat &graph, const MatrixXd &strength, const MatrixXd &stm, bool remove_first = false, std::string reorder = "none", int threads = 0) {
+    return(activation_rate_problem_t(graph, strength, stm, remove_first, reorder, threads));
+}
+
+//' Prepare a partitioned solve of the activation rates
+//'
+//' @noRd
+//' @param graph  the graph
+//' @param strength  the strength of the nodes, one column per seed
+//' @param stm  the stm of the nodes, one column per seed or one shared column
+//' @param remove_first  whether the first node is left out
+//' @param reorder  the order of the nodes the systems are built in
+//' @param threads  the parallel threads, 0 for the default
+//' @return  the external pointer of the problem, which the processes forked
+//'   afterwards share
+// [[Rcpp::export]]
+SEXP activation_rate_problem_d(MMatrixXd &graph, const MatrixXd &strength, const MatrixXd &stm, bool remove_first = false, std::string reorder = "none", int threads = 0) {
+    return(activation_rate_problem_t(graph, strength, stm, remove_first, reorder, threads));
+}
+
+//' Prepare a partitioned solve of the activation rates
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store
+//' @param strength  the strength of the nodes, one column per seed
+//' @param stm  the stm of the nodes, one column per seed or one shared column
+//' @param remove_first  whether the first node is left out
+//' @param reorder  the order of the nodes the systems are built in
+//' @param threads  the parallel threads, 0 for the default
+//' @return  the external pointer of the problem, which the processes forked
+//'   afterwards share
+// [[Rcpp::export]]
+SEXP activation_rate_problem_m(SEXP store, const MatrixXd &strength, const MatrixXd &stm, bool remove_first = false, std::string reorder = "none", int threads = 0) {
+    MSpMat graph = graph_store_matrix(store, 0);
+    return(activation_rate_problem_t(graph, strength, stm, remove_first, reorder, threads));
+}
+
+//' Map the shared segment of a partitioned solve of the activation rates
+//'
+//' @noRd
+//' @param problem  the external pointer of the problem
+//' @param processes  the processes of the solve
+//' @return  the external pointer of the segment, to map before forking
+// [[Rcpp::export]]
+SEXP activation_rate_segment_(SEXP problem, const int processes) {
+    const ActivationProblem &prepared = *XPtr<ActivationProblem>(problem);
+    const Index n = prepared.neighbors.n - prepared.offset;
+    if (processes < 1 || prepared.strength.cols() < 1) {
+        stop("A partitioned solve needs at least one process and one seed.");
+    }
+    ActivationLayout layout(n, processes);
+    SharedSegment *segment = new SharedSegment(layout.bytes, processes);
+    RObject pointer = shared_segment(segment);
+    const vector<Index> bounds = partition_rows(prepared.neighbors.outer.data() + prepared.offset, n, processes);
+    std::copy(bounds.begin(), bounds.end(), segment->array<Index>(layout.bounds));
+    ActivationState *state = segment->array<ActivationState>(layout.state);
+    state->n = n;
+    state->seeds = prepared.strength.cols();
+    return(pointer);
+}
+
+//' Run a part of a partitioned solve of the activation rates
+//'
+//' @noRd
+//' @param segment  the external pointer of the shared segment
+//' @param rank  the part, 0 in the session
+//' @param problem  the external pointer of the problem
+//' @param loose  the loose of the spreading
+//' @param tol  the tolerance of the solver
+//' @param max_iter  the max iterations of the solver, 0 for twice the nodes
+//' @param threads  the threads of the process
+//' @return  the list of activation_rate_s() in the session, and an empty list
+//'   in the workers
+// [[Rcpp::export]]
+List activation_rate_partition_(SEXP segment, const int rank, SEXP problem, double loose = 1.0, double tol = 1e-12, int max_iter = 0, int threads = 1) {
+    SharedSegment *shared = shared_segment(segment);
+    const ActivationProblem &prepared = *XPtr<ActivationProblem>(problem);
+    const Index n = prepared.neighbors.n - prepared.offset;
+    ActivationLayout layout(n, shared->processes());
+    const ActivationState *state = shared->array<ActivationState>(layout.state);
+    if (rank < 0 || rank >= shared->processes() || state->n != n) {
+        stop("The segment does not belong to this solve.");
+    }
+    // The workers multiply their rows on threads of their own, see
+    // parallel_region()
+    if (threads < 1) {
+        stop("A partitioned solve needs at least one thread per process.");
+    }
+    ThreadScope scope(1);
+    const size_t seeds = prepared.strength.cols();
+    Progress p(seeds, false);
+    ActivationResult result;
+    result.tol = tol;
+    result.activation = MatrixXd::Constant(n, seeds, NAN);
+    result.solved.resize(seeds);
+    activation_partition_run(shared, rank, prepared, loose, tol, max_iter, threads, result);
+    if (rank != 0) {
+        return(List());
+    }
+    if (!prepared.kept.empty()) {
+        result.activation = restore_rows(result.activation, prepared.kept);
+    }
+    return(activation_rate_list(result, false));
 }
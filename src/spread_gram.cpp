@@ -29,40 +29,148 @@ ArrayXd sigmoid_t(const ArrayXd &ax, const double &ay, const int u = 1) {
     return(sigma);
 }
 
-template <typename T> vector<double> spread_gram_t(const T &graph, ArrayXd &last_activation, double loose, int threads, bool display_progress) {
-    size_t n = graph.rows();
-    vector<double> next_activation(n);
-    
-    Progress p(n, display_progress);
-    #pragma omp parallel for schedule(guided, 10)
-    for (size_t y = 0; y < n; y++) {
-        // Find all neighbors ID in the graph
-        ArrayXi neighbors = get_neighbors_t(graph, y, 0);
-        ArrayXd neighbors_arr = neighbors.cast<double>();
-
-        // Then, pick the last activation rate from the vector a: ax
-        // VectorXd last_activated = last_activation * neighbors;
-        ArrayXd last_activated = neighbors_arr * last_activation;
-        neighbors.resize(0);                // garbage collection
-        neighbors_arr.resize(0);            // garbage collection
-        p.increment();
-
-        if (last_activated.sum() == 0.0) {
-            next_activation[y] = 0.0;
-        } else {
-            // Next, get a(y)
-            // Compute the similarity between the node pairs (x,y) and sum them up
-            ArrayXd remove_zeros = (last_activated != 0).cast<double>();
-            double doubley = double(y) + 1.0;
-            ArrayXd rate = 1 - sigmoid_t(last_activated, doubley, 1).array();
-            rate = rate * loose * remove_zeros * last_activated;
-            
-            next_activation[y] = rate.sum() + last_activation[y];
+// The sums of Spread-gram over the edges [first_edge, last_edge) of node y,
+// one row per seed: the activation of the neighbors, and the sigmoid sums of
+// the spreading step and of the gradient. The neighbors are gathered into
+// `buffer`, one contiguous column per seed, so the loop does not allocate.
+template <typename A>
+inline void spread_gram_sums(const NeighborList &neighbors, const size_t &y, const size_t &first_edge, const size_t &last_edge, const A &activation, const double &loose, const bool &spread, const bool &gradient, ArrayXd &buffer, ArrayXXd &sums) {
+    size_t degree = last_edge - first_edge, seeds = activation.cols();
+    Map<ArrayXXd> ax(buffer.data(), degree, seeds);
+    for (size_t k = 0; k < degree; k++) {
+        ax.row(k) = activation.row(neighbors.inner[first_edge + k]);
+    }
+    // Compute the similarity between the node pairs (x,y) and sum them up. The
+    // sigmoid takes the original id of y in a reordered graph
+    double doubley = double(neighbors.original_id(y)) + 1.0;
+    sums.resize(seeds, 3);
+    for (size_t seed = 0; seed < seeds; seed++) {
+        sums(seed, 0) = ax.col(seed).sum();
+        sums(seed, 1) = spread ? sigmoid_weighted_sum(ax.col(seed).data(), degree, doubley, loose) : 0.0;
+        sums(seed, 2) = gradient ? sigmoid_weighted_sum(ax.col(seed).data(), degree, activation(y, seed), 1.0) : 0.0;
+    }
+}
+
+// The next activation and the gradient of node y from its sums. A node that
+// cannot be activated has no next activation, and zero gradient since the
+// sigmoid sums skip the zero activation rates.
+template <typename A, typename N>
+inline void spread_gram_finish(const ArrayXXd &sums, const size_t &y, const A &activation, N *next_activation, ArrayXXd *gradient) {
+    for (Index seed = 0; seed < sums.rows(); seed++) {
+        if (next_activation) {
+            (*next_activation)(y, seed) = (sums(seed, 0) == 0.0) ? 0.0 : sums(seed, 1) + activation(y, seed);
+        }
+        if (gradient) {
+            (*gradient)(y, seed) = sums(seed, 2);
+        }
+    }
+}
+
+// One sweep of Spread-gram over the edge-balanced tasks of the neighbor lists,
+// on `workers` threads as in parallel_region(). It fills the rows of the
+// nodes of the tasks in next_activation and gradient, either of which may be
+// null, ticks the progress p and records the sweep in the profile if given.
+// Hubs split across tasks are reduced in task order, so the result does not
+// depend on the schedule or on the number of threads.
+template <typename A, typename N>
+void spread_gram_tasks(const NeighborList &neighbors, const vector<EdgeTask> &tasks, const A &activation, double loose, N *next_activation, ArrayXXd *gradient, Progress *p, KernelProfile *profile, const int &workers) {
+    size_t seeds = activation.cols();
+    size_t max_edges = std::min(neighbors.max_degree(), EDGE_TASK_GRAIN);
+    vector<ArrayXXd> partials(tasks.size());
+    double allocated = 0.0;
+    TaskQueue queue(tasks.size());
+
+    parallel_region(workers, [&]() {
+        double begin = profile ? profile->now() : 0.0;
+        ArrayXd buffer(max_edges * seeds);
+        ArrayXXd sums(seeds, 3);
+
+        for (size_t t; queue.take(t);) {
+            const EdgeTask &task = tasks[t];
+            if (task.split) {
+                spread_gram_sums(neighbors, task.first_node, task.first_edge, task.last_edge, activation, loose, next_activation != nullptr, gradient != nullptr, buffer, partials[t]);
+                continue;
+            }
+            for (size_t y = task.first_node; y < task.last_node; y++) {
+                spread_gram_sums(neighbors, y, neighbors.outer[y], neighbors.outer[y + 1], activation, loose, next_activation != nullptr, gradient != nullptr, buffer, sums);
+                spread_gram_finish(sums, y, activation, next_activation, gradient);
+            }
+            if (p) {
+                p->increment(task.last_node - task.first_node);
+            }
+        }
+        if (profile) {
+            profile->busy(begin);
+            #pragma omp atomic
+            allocated += sizeof(double) * (buffer.size() + sums.size());
+        }
+    });
+
+    for (size_t t = 0; t < tasks.size();) {
+        if (!tasks[t].split) {
+            t++;
+            continue;
+        }
+        size_t y = tasks[t].first_node;
+        ArrayXXd sums = partials[t];
+        for (t++; t < tasks.size() && tasks[t].split && tasks[t].first_node == y; t++) {
+            sums += partials[t];
+        }
+        spread_gram_finish(sums, y, activation, next_activation, gradient);
+        if (p) {
+            p->increment();
         }
     }
+    if (profile) {
+        profile->count("edges", double(neighbors.edges()) * seeds);
+        profile->count("bytes", allocated);
+    }
+}
+
+// A sweep of all the nodes on the OpenMP threads of the kernel
+void spread_gram_sweep(const NeighborList &neighbors, const vector<EdgeTask> &tasks, const RowArrayXXd &activation, double loose, RowArrayXXd *next_activation, ArrayXXd *gradient, Progress *p, KernelProfile *profile = nullptr) {
+    size_t n = neighbors.n, seeds = activation.cols();
+    if (next_activation) {
+        next_activation->resize(n, seeds);
+    }
+    if (gradient) {
+        gradient->resize(n, seeds);
+    }
+    spread_gram_tasks(neighbors, tasks, activation, loose, next_activation, gradient, p, profile, 0);
+}
+
+// The sums of the gradient over the chunks of the rows [first, last), one
+// row of `stride` per chunk in `sums`. The loss of a seed, the mean gradient,
+// adds them up in chunk order, in one process as in several (see
+// PARTITION_CHUNK)
+inline void gradient_chunks(const ArrayXXd &gradient, const Index &first, const Index &last, double *sums, const Index &stride) {
+    chunk_sums(
+        [&](const Index &row, const Index &column) {
+            return(gradient(row, column));
+        },
+        first, last, gradient.cols(), sums, stride);
+}
+
+// Spread all seeds (columns) of last_activation at once, so that each
+// neighbor list is read once per sweep rather than once per seed
+RowArrayXXd spread_gram_t(const NeighborList &neighbors, const RowArrayXXd &last_activation, double loose, bool display_progress) {
+    RowArrayXXd next_activation;
+    Progress p(neighbors.n, display_progress);
+    spread_gram_sweep(neighbors, partition_edges(neighbors), last_activation, loose, &next_activation, nullptr, &p);
     return(next_activation);
 }
 
+vector<double> spread_gram_t(const NeighborList &neighbors, const ArrayXd &last_activation, double loose, bool display_progress) {
+    RowArrayXXd next_activation = spread_gram_t(neighbors, RowArrayXXd(last_activation), loose, display_progress);
+    return(vector<double>(next_activation.data(), next_activation.data() + next_activation.size()));
+}
+
+template <typename T> vector<double> spread_gram_t(const T &graph, ArrayXd &last_activation, double loose, int threads, bool display_progress) {
+    ThreadScope scope(threads);
+    NeighborList neighbors = build_neighbors(graph);
+    return(spread_gram_t(neighbors, last_activation, loose, display_progress));
+}
+
 //' Simulate spreading activation in a network (Only once)
 //' 
 //' @description
@@ -144,41 +252,32 @@ vector<double> spread_gram_d(const MMatrixXd &graph, ArrayXd &last_activation, d
     return(spread_gram_t(graph, last_activation, loose, threads, display_progress));
 }
 
-template <typename T> double gradient_t(const T &graph, ArrayXd &activation, int threads, bool display_progress) {
-    size_t n = graph.rows();
-    VectorXd gradient(n);
-    // vector<double> gradient(n);
-
-    Progress p(n, display_progress);
-    #pragma omp parallel for    // TODO: I want to use dynamic schedule, but it returns NA if I do not sleep 2 secs.
-    // find neighbors line by line
-    for (size_t node = 0; node < n; node++) {
-        ArrayXi neighbors = get_neighbors_t(graph, node, 0);
-        ArrayXd neighbors_arr = neighbors.cast<double>();
-        p.increment();
-
-        if (neighbors_arr.sum() == 0) {
-            // gradient[node] = 0;
-            gradient[node] = 0.0;
-        } else {
-            double ay = activation[node];
-            ArrayXd ax = activation * neighbors_arr;
-            ArrayXd is_zeros = (ax != 0).cast<double>();
-            neighbors_arr = neighbors_arr * is_zeros;
-            ax = ax * is_zeros;
-
-            // consider if the node cannot be activated
-            // vector<double> default_sigma = {0.5};
-            ArrayXd default_sigma = ArrayXi::Ones(1).cast<double>() / 2.0;
-            ArrayXd sigma = (neighbors_arr != 0.0).any() ? sigmoid_t(ax, ay, 1) : default_sigma;
-            ArrayXd s = ax * (neighbors_arr - sigma) * is_zeros;
-            gradient[node] = s.sum();
-        }
+double gradient_t(const NeighborList &neighbors, const vector<EdgeTask> &tasks, const ArrayXd &activation, bool display_progress, KernelProfile *profile = nullptr) {
+    RowArrayXXd activations(activation);
+    ArrayXXd gradient;
+
+    Progress p(neighbors.n, display_progress);
+    spread_gram_sweep(neighbors, tasks, activations, 1.0, nullptr, &gradient, &p, profile);
+    if (profile) {
+        profile->count("iterations", 1.0);
+        profile->count("bytes", double(sizeof(double) * (activations.size() + gradient.size())));
     }
     double mean_gradient = gradient.mean();
     return(mean_gradient);
 }
 
+template <typename T> NumericVector gradient_t(const T &graph, ArrayXd &activation, int threads, bool display_progress, bool profiled) {
+    ThreadScope scope(threads);
+    KernelProfile profile(profiled);
+    profile.start("neighbors");
+    NeighborList neighbors = build_neighbors(graph);
+    const vector<EdgeTask> tasks = partition_edges(neighbors);
+    profile.count("bytes", double(neighbors.bytes() + sizeof(EdgeTask) * tasks.size()));
+    profile.start("propagation");
+    NumericVector mean_gradient(1, gradient_t(neighbors, tasks, activation, display_progress, &profile));
+    return(with_profile(mean_gradient, profile));
+}
+
 //' Compute gradient of Spreadgram - C++ version
 //' 
 //' @description
@@ -203,6 +302,9 @@ template <typename T> double gradient_t(const T &graph, ArrayXd &activation, int
 //'   number of nodes in the graph. This vector should contain the activation 
 //'   rate for each node.
 //'
+//' @param profile Whether to attach the profile of the call as the `profile`
+//'   attribute.
+//'
 //' @return A scalar representing the gradient of the computed activation rates.
 //'   The gradient represents the rate of change of the activation rate.
 //' 
@@ -217,9 +319,9 @@ template <typename T> double gradient_t(const T &graph, ArrayXd &activation, int
 //' 
 // [[Rcpp::plugins("cpp17")]]
 // [[Rcpp::export]]
-double gradient_s(const MSpMat &graph, ArrayXd &activation, int threads = 0, bool display_progress = false) {
+NumericVector gradient_s(const MSpMat &graph, ArrayXd &activation, int threads = 0, bool display_progress = false, bool profile = false) {
     // TODO: mention overloading, help needed
-    return(gradient_t(graph, activation, threads, display_progress));
+    return(gradient_t(graph, activation, threads, display_progress, profile));
 }
 
 //' Compute gradient of Spreadgram - C++ version
@@ -246,6 +348,9 @@ double gradient_s(const MSpMat &graph, ArrayXd &activation, int threads = 0, boo
 //'   number of nodes in the graph. This vector should contain the activation 
 //'   rate for each node.
 //'
+//' @param profile Whether to attach the profile of the call as the `profile`
+//'   attribute.
+//'
 //' @return A scalar representing the gradient of the computed activation rates.
 //'   The gradient represents the rate of change of the activation rate.
 //' 
@@ -260,6 +365,629 @@ double gradient_s(const MSpMat &graph, ArrayXd &activation, int threads = 0, boo
 //' 
 // [[Rcpp::plugins("cpp17")]]
 // [[Rcpp::export]]
-double gradient_d(const MMatrixXd &graph, ArrayXd &activation, int threads = 0, bool display_progress = false) {
-    return(gradient_t(graph, activation, threads, display_progress));
+NumericVector gradient_d(const MMatrixXd &graph, ArrayXd &activation, int threads = 0, bool display_progress = false, bool profile = false) {
+    return(gradient_t(graph, activation, threads, display_progress, profile));
+}
+
+// One fused sweep: both the next activation and the loss of the current
+// activation read the same neighbors, so they are computed together. Returns
+// the loss of each seed in `activation`, not in `next_activation`.
+ArrayXd spread_gram_step_t(const NeighborList &neighbors, const vector<EdgeTask> &tasks, const RowArrayXXd &activation, RowArrayXXd &next_activation, double loose, KernelProfile &profile) {
+    ArrayXXd gradient;
+    spread_gram_sweep(neighbors, tasks, activation, loose, &next_activation, &gradient, nullptr, &profile);
+    const Index n = gradient.rows(), seeds = gradient.cols();
+    RowArrayXXd chunks(partition_chunks(n), seeds);
+    gradient_chunks(gradient, 0, n, chunks.data(), seeds);
+    return(add_chunks(chunks.data(), chunks.rows(), seeds, seeds).transpose().array() / double(n));
+}
+
+// The graph and the activation of an iteration, prepared in the session: the
+// neighbor lists are copied out of the R objects, so that the iteration may
+// run in the background. In a reordered graph the rows of the activation are
+// in the permuted order, and the activation is mapped back by `order`
+struct SpreadGramProblem {
+    NeighborList neighbors;
+    vector<EdgeTask> tasks;
+    vector<int> order;
+    MatrixXd activation;
+};
+
+// The outcome of an iteration, converted to a List by spread_gram_list()
+struct SpreadGramResult {
+    MatrixXd activation;
+    vector<vector<double>> loss;
+    vector<int> iterations;
+    vector<bool> convergence;
+};
+
+// The stopping rules of the iteration: the loss drops below the threshold, or
+// the last 20 losses stay the same after min_iter iterations. Every seed stops
+// on its own
+struct SpreadGramTrace {
+    int min_iter;
+    double threshold;
+    vector<vector<double>> last_gradient, losses;
+    vector<int> iterations;
+    vector<bool> convergence;
+
+    SpreadGramTrace(const size_t &seeds, const int &max_iter, const double &threshold) : min_iter(std::max(int(std::nearbyint(max_iter / 100.0)), 500)), threshold(threshold), last_gradient(seeds, vector<double>(20, double(max_iter))), losses(seeds), iterations(seeds, max_iter), convergence(seeds, false) {}
+
+    // Record the loss of a seed in iteration `iter`, and whether it converges
+    bool add(const size_t &seed, const double &loss, const int &iter) {
+        vector<double> &window = last_gradient[seed];
+        losses[seed].push_back(loss);
+        std::rotate(window.begin(), window.begin() + 1, window.end());
+        window.back() = loss;
+
+        // Check if convergence
+        bool flat = std::all_of(window.begin(), window.end(), [&](double g) {
+            return(g == window.front());
+        });
+        if ((loss < threshold) || ((iter > min_iter) && flat)) {
+            convergence[seed] = true;
+            iterations[seed] = iter;
+        }
+        return(convergence[seed]);
+    }
+};
+
+// The whole iteration
+SpreadGramResult spread_gram_iterate(const SpreadGramProblem &problem, double loose, int max_iter, double threshold, bool display_progress, KernelProfile &profile, KernelMonitor &monitor) {
+    const NeighborList &neighbors = problem.neighbors;
+    const vector<EdgeTask> &tasks = problem.tasks;
+    const MatrixXd &last_activation = problem.activation;
+    const vector<int> &order = problem.order;
+    size_t n = neighbors.n, seeds = last_activation.cols();
+
+    // Converged seeds are dropped from later sweeps
+    int freq = std::max(int(std::nearbyint(2e4 / n)), 1);
+    SpreadGramTrace trace(seeds, max_iter, threshold);
+    vector<vector<double>> &losses = trace.losses;
+    vector<int> &iterations = trace.iterations;
+    vector<bool> &convergence = trace.convergence;
+    vector<size_t> active(seeds);
+    std::iota(active.begin(), active.end(), 0);
+    MatrixXd activated = last_activation;
+
+    // The loss of the activation in iteration t is only known after the sweep
+    // computing iteration t + 1, so the activation stays one sweep ahead
+    RowArrayXXd activation = last_activation.array();
+    RowArrayXXd next_activation;
+    if (max_iter > 0) {
+        spread_gram_sweep(neighbors, tasks, activation, loose, &next_activation, nullptr, nullptr, &profile);
+        activation.swap(next_activation);
+    }
+    profile.count("bytes", double(sizeof(double) * 2 * activation.size() + sizeof(double) * 2 * activated.size()));
+    int iter = 0;
+
+    while (iter < max_iter && !active.empty()) {
+        if (monitor.aborted()) {
+            break;
+        }
+        ArrayXd loss = spread_gram_step_t(neighbors, tasks, activation, next_activation, loose, profile);
+
+        vector<size_t> still_active;
+        for (size_t i = 0; i < active.size(); i++) {
+            size_t seed = active[i];
+            if (display_progress && seeds == 1 && iter % freq == 0) {
+                Rprintf("Iterated #%i times. Current loss: %g\n", iter, loss[i]);
+            }
+            if (trace.add(seed, loss[i], iter)) {
+                activated.col(seed) = activation.col(i).matrix();
+            } else {
+                still_active.push_back(i);
+            }
+        }
+        if (display_progress && seeds > 1 && iter % freq == 0) {
+            Rprintf("Iterated #%i times. %i of %i seeds converged.\n", iter, int(seeds - still_active.size()), int(seeds));
+        }
+
+        iter++;
+        // Drop converged seeds
+        if (still_active.size() < active.size()) {
+            RowArrayXXd kept_activation(n, still_active.size()), kept_next(n, still_active.size());
+            vector<size_t> kept_seeds;
+            for (size_t i = 0; i < still_active.size(); i++) {
+                kept_activation.col(i) = activation.col(still_active[i]);
+                kept_next.col(i) = next_activation.col(still_active[i]);
+                kept_seeds.push_back(active[still_active[i]]);
+            }
+            activation.swap(kept_activation);
+            next_activation.swap(kept_next);
+            active.swap(kept_seeds);
+        }
+        if (iter < max_iter) {
+            activation.swap(next_activation);
+        }
+
+        monitor.increment();
+        vector<double> last_loss(seeds, NAN);
+        for (size_t seed = 0; seed < seeds; seed++) {
+            if (!losses[seed].empty()) {
+                last_loss[seed] = losses[seed].back();
+            }
+        }
+        monitor.report_loss(last_loss);
+        if (monitor.partial_requested()) {
+            MatrixXd partial = activated;
+            for (size_t i = 0; i < active.size(); i++) {
+                partial.col(active[i]) = activation.col(i).matrix();
+            }
+            monitor.publish_partial(order.empty() ? partial : restore_rows(partial, order));
+        }
+    }
+
+    // Seeds that never converge
+    for (size_t i = 0; i < active.size(); i++) {
+        iterations[active[i]] = iter;
+        activated.col(active[i]) = activation.col(i).matrix();
+    }
+
+    if (display_progress) {
+        for (size_t seed = 0; seed < seeds; seed++) {
+            double loss = losses[seed].empty() ? NAN : losses[seed].back();
+            if (convergence[seed]) {
+                Rprintf("Convergent at #%i times. Current loss: %g\n", iterations[seed], loss);
+            } else {
+                Rprintf("Not convergent after #%i times. Current loss: %g\n", iterations[seed], loss);
+            }
+        }
+    }
+
+    if (!order.empty()) {
+        activated = restore_rows(activated, order);
+    }
+    profile.count("iterations", double(iter));
+    return(SpreadGramResult{activated, losses, iterations, convergence});
+}
+
+List spread_gram_list(const SpreadGramResult &result) {
+    List loss_trace(result.loss.size());
+    for (size_t seed = 0; seed < result.loss.size(); seed++) {
+        loss_trace[seed] = result.loss[seed];
+    }
+    return(List::create(Named("activation") = result.activation,
+                        Named("loss") = loss_trace,
+                        Named("iterations") = result.iterations,
+                        Named("convergence") = result.convergence));
+}
+
+template <typename T> SpreadGramProblem spread_gram_problem(const T &graph, const MatrixXd &last_activation, const std::string &reorder, KernelProfile &profile) {
+    SpreadGramProblem problem;
+    // In a reordered graph the sweeps run in the permuted order
+    profile.start("neighbors");
+    problem.neighbors = build_neighbors(graph);
+    if (reorder != "none") {
+        profile.start("reorder");
+        problem.order = graph_order(problem.neighbors, reorder, false);
+        problem.neighbors = permute_neighbors(problem.neighbors, problem.order);
+        profile.start("neighbors");
+    }
+    problem.tasks = partition_edges(problem.neighbors);
+    problem.activation = problem.order.empty() ? last_activation : permute_rows(last_activation, problem.order);
+    profile.count("bytes", double(problem.neighbors.bytes() + sizeof(EdgeTask) * problem.tasks.size()));
+    return(problem);
+}
+
+SpreadGramResult spread_gram_run(const SpreadGramProblem &problem, double loose, int max_iter, double threshold, bool display_progress, KernelProfile &profile, KernelMonitor &monitor) {
+    profile.start("propagation");
+    return(spread_gram_iterate(problem, loose, max_iter, threshold, display_progress, profile, monitor));
+}
+
+// Run the iteration, or submit it as a background job on `async` workers of
+// the job pool, see jobs.cpp. The neighbor lists are built in the session on
+// the thread budget either way
+template <typename T> SEXP spread_gram_iter_t(const T &graph, const MatrixXd &last_activation, double loose, int max_iter, double threshold, int threads, bool display_progress, const std::string &reorder, bool profiled, int async) {
+    ThreadScope scope(threads);
+    auto profile = std::make_shared<KernelProfile>(profiled);
+    auto problem = std::make_shared<SpreadGramProblem>(spread_gram_problem(graph, last_activation, reorder, *profile));
+    if (async <= 0) {
+        KernelMonitor monitor(max_iter, false);
+        return(with_profile(spread_gram_list(spread_gram_run(*problem, loose, max_iter, threshold, display_progress, *profile, monitor)), *profile));
+    }
+
+    auto result = std::make_shared<SpreadGramResult>();
+    auto job = std::make_shared<Job>(threads);
+    job->work = [=](Job &job) {
+        KernelMonitor monitor(max_iter, false, &job);
+        *result = spread_gram_run(*problem, loose, max_iter, threshold, false, *profile, monitor);
+    };
+    job->collect = [=]() {
+        return(wrap(with_profile(spread_gram_list(*result), *profile)));
+    };
+    return(submit_job(job, async));
+}
+
+//' Simulate spreading activation in a network until convergence
+//'
+//' @description
+//' It runs the whole Spread-gram iteration natively. Each sweep computes the
+//'   next activation and the loss of the current activation in one pass over
+//'   the neighbors.
+//'
+//' @param graph A square \code{\link[Matrix:dgCMatrix-class]{dgCMatrix}}
+//'   representing the background graph.
+//'
+//' @param last_activation A matrix that containing the initial activation
+//'   rates of all nodes, one column per seed. The sequence is the same as the
+//'   matrix.
+//'
+//' @param loose A scalar numeric between 0 and 1 that determines the loose (or
+//'   weight) in the calculation process.
+//'
+//' @param max_iter Max iteration times.
+//'
+//' @param threshold End threshold of the loss.
+//'
+//' @param reorder The order of the nodes the sweeps run in: none, rcm, degree
+//'   or community. The activation is always in the order of the graph.
+//'
+//' @param profile Whether to attach the profile of the call as the `profile`
+//'   attribute.
+//'
+//' @param async 0 to run in the session, or the number of workers of the job
+//'   pool to run it on in the background.
+//'
+//' @return A list containing the activation matrix, and for each seed the loss
+//'   of each iteration, the iteration times and whether it converges, or the
+//'   external pointer of the job if `async` is positive.
+//'
+//' @noRd
+// [[Rcpp::plugins("cpp17")]]
+// [[Rcpp::export]]
+SEXP spread_gram_iter_s(const MSpMat &graph, const MatrixXd &last_activation, double loose = 1.0, int max_iter = 100000, double threshold = 1.0, int threads = 0, bool display_progress = false, std::string reorder = "none", bool profile = false, int async = 0) {
+    return(spread_gram_iter_t(graph, last_activation, loose, max_iter, threshold, threads, display_progress, reorder, profile, async));
+}
+
+//' Simulate spreading activation in a network until convergence
+//'
+//' @description
+//' It runs the whole Spread-gram iteration natively. Each sweep computes the
+//'   next activation and the loss of the current activation in one pass over
+//'   the neighbors.
+//'
+//' @param graph A square \code{\link[base]{matrix}} representing the
+//'   background graph.
+//'
+//' @param last_activation A matrix that containing the initial activation
+//'   rates of all nodes, one column per seed. The sequence is the same as the
+//'   matrix.
+//'
+//' @param loose A scalar numeric between 0 and 1 that determines the loose (or
+//'   weight) in the calculation process.
+//'
+//' @param max_iter Max iteration times.
+//'
+//' @param threshold End threshold of the loss.
+//'
+//' @param reorder The order of the nodes the sweeps run in: none, rcm, degree
+//'   or community. The activation is always in the order of the graph.
+//'
+//' @param profile Whether to attach the profile of the call as the `profile`
+//'   attribute.
+//'
+//' @param async 0 to run in the session, or the number of workers of the job
+//'   pool to run it on in the background.
+//'
+//' @return A list containing the activation matrix, and for each seed the loss
+//'   of each iteration, the iteration times and whether it converges, or the
+//'   external pointer of the job if `async` is positive.
+//'
+//' @noRd
+// [[Rcpp::plugins("cpp17")]]
+// [[Rcpp::export]]
+SEXP spread_gram_iter_d(const MMatrixXd &graph, const MatrixXd &last_activation, double loose = 1.0, int max_iter = 100000, double threshold = 1.0, int threads = 0, bool display_progress = false, std::string reorder = "none", bool profile = false, int async = 0) {
+    return(spread_gram_iter_t(graph, last_activation, loose, max_iter, threshold, threads, display_progress, reorder, profile, async));
+}
+
+//' Simulate spreading activation in a network until convergence
+//'
+//' @description
+//' It runs the whole Spread-gram iteration natively on the graph of a graph
+//'   store, which is read from the mapped file without copying.
+//'
+//' @param store The external pointer of a graph store.
+//'
+//' @param last_activation A matrix that containing the initial activation
+//'   rates of all nodes, one column per seed. The sequence is the same as the
+//'   store.
+//'
+//' @param loose A scalar numeric between 0 and 1 that determines the loose (or
+//'   weight) in the calculation process.
+//'
+//' @param max_iter Max iteration times.
+//'
+//' @param threshold End threshold of the loss.
+//'
+//' @param reorder The order of the nodes the sweeps run in: none, rcm, degree
+//'   or community. The activation is always in the order of the graph.
+//'
+//' @param profile Whether to attach the profile of the call as the `profile`
+//'   attribute.
+//'
+//' @param async 0 to run in the session, or the number of workers of the job
+//'   pool to run it on in the background.
+//'
+//' @return A list containing the activation matrix, and for each seed the loss
+//'   of each iteration, the iteration times and whether it converges, or the
+//'   external pointer of the job if `async` is positive.
+//'
+//' @noRd
+// [[Rcpp::plugins("cpp17")]]
+// [[Rcpp::export]]
+SEXP spread_gram_iter_m(SEXP store, const MatrixXd &last_activation, double loose = 1.0, int max_iter = 100000, double threshold = 1.0, int threads = 0, bool display_progress = false, std::string reorder = "none", bool profile = false, int async = 0) {
+    const MSpMat graph = graph_store_matrix(store, 0);
+    return(spread_gram_iter_t(graph, last_activation, loose, max_iter, threshold, threads, display_progress, reorder, profile, async));
+}
+
+// Spread-gram partitioned over processes forked from the session, see
+// partitioned_run() in R and the partitioned walk in random_walk.cpp. The
+// session prepares the problem, whose neighbor lists the workers inherit and
+// read in place. Every process owns a block of nodes, in whole chunks with
+// about the same number of edges (see partition_rows()), and sweeps them on
+// its share of the threads: it writes its rows of the next activation into
+// the SharedSegment, reading the activation of the neighbors in the other
+// blocks (its halo) from the last sweep, and the sums of its gradient by
+// chunks of rows. After the barrier, rank 0 adds up the chunks into the loss
+// of every seed in the order spread_gram_step_t() does, and applies the
+// stopping rules of spread_gram_iterate(), so the result is the same as in
+// one process. Every process then moves the kept seeds of its own rows.
+
+// The seeds swept together
+const Index SPREAD_BLOCK = 16;
+
+// The state of the block of seeds being swept, which rank 0 writes between
+// two barriers and the others read after the second. The activation
+// alternates between two buffers, and `compact` is set when the kept seeds
+// of the next activation move to the buffer of the current one
+struct SpreadGramState {
+    Index n, seeds, width;
+    int compact, stop;
+};
+
+// The offsets of the arrays of the iteration in its segment: the bounds of
+// the nodes of every process, the state, the gradient sums of every chunk of
+// nodes, the kept seeds and the two activations
+struct SpreadGramLayout {
+    size_t bounds, state, loss, kept, activation[2], bytes;
+
+    SpreadGramLayout(const Index &n, const int &processes) {
+        auto align = [](const size_t &offset) {
+            return((offset + 63) / 64 * 64);
+        };
+        const size_t block = sizeof(double) * n * SPREAD_BLOCK;
+        bounds = 0;
+        state = align(sizeof(Index) * (processes + 1));
+        loss = align(state + sizeof(SpreadGramState));
+        kept = align(loss + sizeof(double) * partition_chunks(n) * SPREAD_BLOCK);
+        activation[0] = align(kept + sizeof(Index) * SPREAD_BLOCK);
+        activation[1] = align(activation[0] + block);
+        bytes = activation[1] + block;
+    }
+};
+
+// Run the part `rank` of the iteration on `threads` threads. Rank 0 sets up
+// every block of seeds and fills the trace and the activation
+void spread_gram_partition_iterate(SharedSegment *segment, const int &rank, const SpreadGramProblem &problem, const double &loose, const int &max_iter, const int &threads, SpreadGramTrace &trace, MatrixXd &activated) {
+    const NeighborList &neighbors = problem.neighbors;
+    SpreadGramLayout layout(neighbors.n, segment->processes());
+    SpreadGramState *state = segment->array<SpreadGramState>(layout.state);
+    const Index n = state->n, seeds = state->seeds;
+    const Index *bounds = segment->array<Index>(layout.bounds);
+    const Index first_row = bounds[rank], rows = bounds[rank + 1] - first_row;
+    const vector<EdgeTask> tasks = partition_edge_range(neighbors.outer.data(), first_row, first_row + rows);
+    double *buffers[2] = {segment->array<double>(layout.activation[0]), segment->array<double>(layout.activation[1])};
+    double *loss = segment->array<double>(layout.loss);
+    Index *kept = segment->array<Index>(layout.kept);
+
+    try {
+        ArrayXXd gradient;
+        for (Index first = 0; first < seeds; first += SPREAD_BLOCK) {
+            vector<size_t> active;
+            int iter = 0;
+            // Every rank has read the end of the last block before rank 0
+            // sets up this one
+            segment->wait(rank);
+            if (rank == 0) {
+                Index width = std::min(SPREAD_BLOCK, seeds - first);
+                state->width = width;
+                state->compact = 0;
+                state->stop = max_iter <= 0;
+                Map<RowArrayXXd>(buffers[0], n, width) = problem.activation.middleCols(first, width).array();
+                active.resize(width);
+                std::iota(active.begin(), active.end(), size_t(first));
+                // Seeds that are never swept
+                if (state->stop) {
+                    for (size_t seed : active) {
+                        trace.iterations[seed] = 0;
+                    }
+                }
+            }
+            segment->wait(rank);
+            if (state->stop) {
+                continue;
+            }
+
+            // The activation stays one sweep ahead, see spread_gram_iterate()
+            Map<RowArrayXXd> initial(buffers[0], n, state->width), swept(buffers[1], n, state->width);
+            spread_gram_tasks(neighbors, tasks, initial, loose, &swept, nullptr, nullptr, nullptr, threads);
+            segment->wait(rank);
+
+            int current = 1;
+            while (true) {
+                const Index width = state->width;
+                Map<RowArrayXXd> activation(buffers[current], n, width), next(buffers[1 - current], n, width);
+                gradient.resize(n, width);
+                spread_gram_tasks(neighbors, tasks, activation, loose, &next, &gradient, nullptr, nullptr, threads);
+                gradient_chunks(gradient, first_row, first_row + rows, loss, SPREAD_BLOCK);
+                segment->wait(rank);
+
+                if (rank == 0) {
+                    ArrayXd step = add_chunks(loss, partition_chunks(n), width, SPREAD_BLOCK).transpose().array() / double(n);
+                    vector<size_t> kept_seeds;
+                    for (size_t i = 0; i < active.size(); i++) {
+                        if (trace.add(active[i], step[i], iter)) {
+                            activated.col(active[i]) = activation.col(i).matrix();
+                        } else {
+                            kept[kept_seeds.size()] = Index(i);
+                            kept_seeds.push_back(active[i]);
+                        }
+                    }
+                    iter++;
+                    state->stop = kept_seeds.empty() || iter >= max_iter || Progress::check_abort();
+
+                    // Seeds that never converge keep the last activation swept,
+                    // or the next one if the iteration is interrupted
+                    if (state->stop) {
+                        for (size_t i = 0; i < kept_seeds.size(); i++) {
+                            trace.iterations[kept_seeds[i]] = iter;
+                            if (iter >= max_iter) {
+                                activated.col(kept_seeds[i]) = activation.col(kept[i]).matrix();
+                            } else {
+                                activated.col(kept_seeds[i]) = next.col(kept[i]).matrix();
+                            }
+                        }
+                    }
+
+                    // Converged seeds are dropped: the kept ones move to the
+                    // buffer of the current activation, which nobody reads
+                    // any more
+                    state->compact = !state->stop && Index(kept_seeds.size()) < width;
+                    state->width = Index(kept_seeds.size());
+                    active.swap(kept_seeds);
+                }
+                segment->wait(rank);
+                if (state->stop) {
+                    break;
+                }
+                if (state->compact) {
+                    const Index kept_width = state->width;
+                    Map<RowArrayXXd> next_kept(buffers[current], n, kept_width);
+                    for (Index i = 0; i < kept_width; i++) {
+                        next_kept.col(i).segment(first_row, rows) = next.col(kept[i]).segment(first_row, rows);
+                    }
+                    segment->wait(rank);
+                } else {
+                    current = 1 - current;
+                }
+            }
+        }
+    } catch (...) {
+        segment->fail();
+        throw;
+    }
+}
+
+template <typename T> SEXP spread_gram_problem_t(const T &graph, const MatrixXd &last_activation, const std::string &reorder, int threads) {
+    ThreadScope scope(threads);
+    KernelProfile profile(false);
+    return(XPtr<SpreadGramProblem>(new SpreadGramProblem(spread_gram_problem(graph, last_activation, reorder, profile)), true));
+}
+
+//' Prepare a partitioned Spread-gram iteration
+//'
+//' @noRd
+//' @param graph  the graph
+//' @param last_activation  the initial activation, one column per seed
+//' @param reorder  the order of the nodes the sweeps run in
+//' @param threads  the parallel threads, 0 for the default
+//' @return  the external pointer of the problem, which the processes forked
+//'   afterwards share
+// [[Rcpp::export]]
+SEXP spread_gram_problem_s(const MSpMat &graph, const MatrixXd &last_activation, std::string reorder = "none", int threads = 0) {
+    return(spread_gram_problem_t(graph, last_activation, reorder, threads));
+}
+
+//' Prepare a partitioned Spread-gram iteration
+//'
+//' @noRd
+//' @param graph  the graph
+//' @param last_activation  the initial activation, one column per seed
+//' @param reorder  the order of the nodes the sweeps run in
+//' @param threads  the parallel threads, 0 for the default
+//' @return  the external pointer of the problem, which the processes forked
+//'   afterwards share
+// [[Rcpp::export]]
+SEXP spread_gram_problem_d(const MMatrixXd &graph, const MatrixXd &last_activation, std::string reorder = "none", int threads = 0) {
+    return(spread_gram_problem_t(graph, last_activation, reorder, threads));
+}
+
+//' Prepare a partitioned Spread-gram iteration
+//'
+//' @noRd
+//' @param store  the external pointer of a graph store
+//' @param last_activation  the initial activation, one column per seed
+//' @param reorder  the order of the nodes the sweeps run in
+//' @param threads  the parallel threads, 0 for the default
+//' @return  the external pointer of the problem, which the processes forked
+//'   afterwards share
+// [[Rcpp::export]]
+SEXP spread_gram_problem_m(SEXP store, const MatrixXd &last_activation, std::string reorder = "none", int threads = 0) {
+    const MSpMat graph = graph_store_matrix(store, 0);
+    return(spread_gram_problem_t(graph, last_activation, reorder, threads));
+}
+
+//' Map the shared segment of a partitioned Spread-gram iteration
+//'
+//' @noRd
+//' @param problem  the external pointer of the problem
+//' @param processes  the processes of the iteration
+//' @return  the external pointer of the segment, to map before forking
+// [[Rcpp::export]]
+SEXP spread_gram_segment_(SEXP problem, const int processes) {
+    const SpreadGramProblem &prepared = *XPtr<SpreadGramProblem>(problem);
+    const Index n = prepared.neighbors.n;
+    if (processes < 1 || prepared.activation.cols() < 1) {
+        stop("A partitioned iteration needs at least one process and one seed.");
+    }
+    SpreadGramLayout layout(n, processes);
+    SharedSegment *segment = new SharedSegment(layout.bytes, processes);
+    RObject pointer = shared_segment(segment);
+    const vector<Index> bounds = partition_rows(prepared.neighbors.outer.data(), n, processes);
+    std::copy(bounds.begin(), bounds.end(), segment->array<Index>(layout.bounds));
+    SpreadGramState *state = segment->array<SpreadGramState>(layout.state);
+    state->n = n;
+    state->seeds = prepared.activation.cols();
+    return(pointer);
+}
+
+//' Run a part of a partitioned Spread-gram iteration
+//'
+//' @noRd
+//' @param segment  the external pointer of the shared segment
+//' @param rank  the part, 0 in the session
+//' @param problem  the external pointer of the problem
+//' @param loose  the loose of the spreading
+//' @param max_iter  max iteration times
+//' @param threshold  end threshold of the loss
+//' @param threads  the threads of the process
+//' @return  the list of spread_gram_iter_s() in the session, and an empty
+//'   list in the workers
+// [[Rcpp::export]]
+List spread_gram_partition_(SEXP segment, const int rank, SEXP problem, double loose = 1.0, int max_iter = 100000, double threshold = 1.0, int threads = 1) {
+    SharedSegment *shared = shared_segment(segment);
+    const SpreadGramProblem &prepared = *XPtr<SpreadGramProblem>(problem);
+    SpreadGramLayout layout(prepared.neighbors.n, shared->processes());
+    const SpreadGramState *state = shared->array<SpreadGramState>(layout.state);
+    if (rank < 0 || rank >= shared->processes() || state->n != Index(prepared.neighbors.n)) {
+        stop("The segment does not belong to this iteration.");
+    }
+    // The workers take the tasks of their nodes on threads of their own, see
+    // parallel_region()
+    if (threads < 1) {
+        stop("A partitioned iteration needs at least one thread per process.");
+    }
+    ThreadScope scope(1);
+    const size_t seeds = prepared.activation.cols();
+    Progress p(seeds, false);
+    SpreadGramTrace trace(seeds, max_iter, threshold);
+    MatrixXd activated = prepared.activation;
+    spread_gram_partition_iterate(shared, rank, prepared, loose, max_iter, threads, trace, activated);
+    if (rank != 0) {
+        return(List());
+    }
+    if (!prepared.order.empty()) {
+        activated = restore_rows(activated, prepared.order);
+    }
+    return(spread_gram_list(SpreadGramResult{activated, trace.losses, trace.iterations, trace.convergence}));
 }
@@ -0,0 +1,154 @@
+#include "../inst/include/labyrinth.h"
+
+// Synthetic graphs for benchmarks, drawn straight into a sparse matrix in time
+// and memory linear in the number of edges, so that graphs of 10^5 - 10^6
+// nodes need no dense intermediate. They draw from the random number generator
+// of R, so set.seed() reproduces them. Repeated draws of the same edge and
+// self-edges are dropped, so a graph may have slightly fewer edges than drawn.
+
+// A uniform index in [0, n)
+inline size_t random_index(const size_t &n) {
+    return(std::min(size_t(R::unif_rand() * double(n)), n - 1));
+}
+
+inline double edge_weight(const bool &weighted) {
+    return(weighted ? 0.01 + 2.99 * R::unif_rand() : 1.0);
+}
+
+// Collapse the drawn edges into a matrix, keeping the first of the repeated
+// draws
+SpMat edges_to_matrix(const size_t &n, const vector<Triplet<double>> &edges) {
+    SpMat graph(n, n);
+    graph.setFromTriplets(edges.begin(), edges.end(), [](const double &first, const double &) {
+        return(first);
+    });
+    graph.makeCompressed();
+    return(graph);
+}
+
+// Both directions of an undirected edge
+inline void add_undirected(vector<Triplet<double>> &edges, const size_t &u, const size_t &v, const double &weight) {
+    if (u != v) {
+        edges.emplace_back(u, v, weight);
+        edges.emplace_back(v, u, weight);
+    }
+}
+
+//' Draw a directed Erdos-Renyi graph.
+//'
+//' @noRd
+//' @param n  the number of nodes
+//' @param p  the probability of each directed edge between two nodes
+//' @param weighted  boolean if the edges have uniform weights in [0.01, 3]
+//'   instead of 1
+//' @return  returns the adjacency matrix
+// [[Rcpp::export]]
+SpMat erdos_renyi_(const int n, const double p, const bool weighted = false) {
+    if (n < 2 || p < 0 || p > 1) {
+        stop("Need at least 2 nodes and a probability in [0, 1].");
+    }
+    // Geometric skips over the n (n - 1) slots (Batagelj & Brandes, 2005),
+    // slot k being the edge from node k / (n - 1) to another node
+    const uint64_t others = uint64_t(n) - 1, slots = uint64_t(n) * others;
+    vector<Triplet<double>> edges;
+    edges.reserve(size_t(double(slots) * p * 1.01) + 16);
+    const double log_q = std::log1p(-p);
+    uint64_t k = 0;
+    while (p > 0) {
+        if (p < 1) {
+            double skip = std::floor(std::log1p(-R::unif_rand()) / log_q);
+            if (skip >= double(slots - k)) {
+                break;
+            }
+            k += uint64_t(skip);
+        }
+        if (k >= slots) {
+            break;
+        }
+        uint64_t from = k / others, to = k % others;
+        if (to >= from) {
+            to++;
+        }
+        edges.emplace_back(Index(from), Index(to), edge_weight(weighted));
+        k++;
+    }
+    return(edges_to_matrix(n, edges));
+}
+
+//' Draw an undirected Barabasi-Albert graph.
+//'
+//' @noRd
+//' @param n  the number of nodes
+//' @param m  the edges attached by every new node
+//' @param weighted  boolean if the edges have uniform weights in [0.01, 3]
+//'   instead of 1
+//' @return  returns the symmetric adjacency matrix
+// [[Rcpp::export]]
+SpMat barabasi_albert_(const int n, const int m, const bool weighted = false) {
+    if (n < 2 || m < 1) {
+        stop("Need at least 2 nodes and 1 edge per node.");
+    }
+    // Linear-time preferential attachment (Batagelj & Brandes, 2005): the
+    // endpoints of the edges so far list every node once per degree, so a
+    // uniform endpoint is a node drawn proportional to its degree
+    vector<int> endpoints(2 * size_t(n) * m);
+    vector<Triplet<double>> edges;
+    edges.reserve(endpoints.size());
+    for (size_t v = 0; v < size_t(n); v++) {
+        for (size_t i = 0; i < size_t(m); i++) {
+            size_t slot = 2 * (v * m + i);
+            endpoints[slot] = int(v);
+            endpoints[slot + 1] = endpoints[random_index(slot + 1)];
+            add_undirected(edges, v, endpoints[slot + 1], edge_weight(weighted));
+        }
+    }
+    return(edges_to_matrix(n, edges));
+}
+
+// Cumulative weights (i + 1)^(-1 / (exponent - 1)) of the nodes of a block,
+// whose expected degrees follow a power law of the exponent (Chung & Lu, 2002)
+vector<double> power_law_weights(const size_t &n, const double &exponent) {
+    vector<double> cumulative(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += std::pow(double(i + 1), -1.0 / (exponent - 1.0));
+        cumulative[i] = sum;
+    }
+    return(cumulative);
+}
+
+inline size_t draw_weighted(const vector<double> &cumulative) {
+    double target = R::unif_rand() * cumulative.back();
+    size_t index = std::upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin();
+    return(std::min(index, cumulative.size() - 1));
+}
+
+//' Draw an undirected bipartite graph between drugs and diseases.
+//'
+//' @noRd
+//' @param drugs  the number of drugs, the first nodes
+//' @param diseases  the number of diseases, the last nodes
+//' @param edges  the number of drug-disease edges drawn
+//' @param exponent  the exponent of the power law of the degrees in each
+//'   block, greater than 2
+//' @param weighted  boolean if the edges have uniform weights in [0.01, 3]
+//'   instead of 1
+//' @return  returns the symmetric adjacency matrix
+// [[Rcpp::export]]
+SpMat bipartite_graph_(const int drugs, const int diseases, const double edges, const double exponent = 2.5, const bool weighted = false) {
+    if (drugs < 1 || diseases < 1 || edges < 0 || exponent <= 2) {
+        stop("Need drugs, diseases, a non-negative number of edges and an exponent greater than 2.");
+    }
+    // Hubs are both drugs and diseases: the blocks draw their endpoints
+    // independently, in proportion to the power-law weights
+    vector<double> drug_weights = power_law_weights(drugs, exponent);
+    vector<double> disease_weights = power_law_weights(diseases, exponent);
+    vector<Triplet<double>> triplets;
+    triplets.reserve(2 * size_t(edges));
+    for (size_t e = 0; e < size_t(edges); e++) {
+        size_t drug = draw_weighted(drug_weights);
+        size_t disease = size_t(drugs) + draw_weighted(disease_weights);
+        add_undirected(triplets, drug, disease, edge_weight(weighted));
+    }
+    return(edges_to_matrix(size_t(drugs) + diseases, triplets));
+}
@@ -0,0 +1,219 @@
+#include "../inst/include/labyrinth.h"
+#ifdef __linux__
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// The threading runtime of the kernels. Each kernel call scopes its thread
+// budget with a ThreadScope instead of calling omp_set_num_threads() for the
+// whole session, so that several R workers on a host can split the cores
+// between them with thread_options_(), and a call with fewer threads does not
+// slow down the next ones.
+
+// The defaults of the scopes. The job workers read them too, hence atomic
+std::atomic<int> default_threads{0}, default_binding{BIND_NONE};
+
+const char *BINDINGS[] = {"none", "cores", "numa"};
+
+#ifdef __linux__
+// Sorted ids of a list such as "0-3,8,10-11" of sysfs
+vector<int> parse_id_list(const std::string &list) {
+    vector<int> ids;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int id = first; id <= last; id++) {
+                ids.push_back(id);
+            }
+        } catch (const std::exception &) {
+            continue;
+        }
+    }
+    return(ids);
+}
+
+// The first line of a file, or empty if it cannot be read
+std::string read_line(const std::string &path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return(line);
+}
+
+vector<int> thread_affinity() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    vector<int> cpus;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return(cpus);
+}
+
+void set_thread_affinity(const vector<int> &cpus) {
+    if (cpus.empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// The places threads are pinned to, among the CPUs the calling thread may
+// run on: the first hardware thread of every physical core, or the CPUs of
+// every NUMA node. The thread i of a team goes to the place i modulo their
+// number
+vector<vector<int>> thread_places(const int &binding, const vector<int> &allowed) {
+    vector<vector<int>> places;
+    if (binding == BIND_CORES) {
+        std::set<pair<int, int>> cores;
+        for (int cpu : allowed) {
+            std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            std::string core = read_line(topology + "core_id"), package = read_line(topology + "physical_package_id");
+            // Without the topology, every CPU is a core of its own
+            pair<int, int> id(-1, cpu);
+            if (!core.empty() && !package.empty()) {
+                id = make_pair(std::atoi(package.c_str()), std::atoi(core.c_str()));
+            }
+            if (cores.insert(id).second) {
+                places.push_back({cpu});
+            }
+        }
+    } else if (binding == BIND_NUMA) {
+        for (int node : parse_id_list(read_line("/sys/devices/system/node/online"))) {
+            vector<int> cpus = parse_id_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist")), local;
+            std::set_intersection(cpus.begin(), cpus.end(), allowed.begin(), allowed.end(), std::back_inserter(local));
+            if (!local.empty()) {
+                places.push_back(local);
+            }
+        }
+    }
+    return(places);
+}
+#endif
+
+ThreadScope::ThreadScope(const int &threads) {
+#ifdef _OPENMP
+    saved_threads = omp_get_max_threads();
+    saved_levels = omp_get_max_active_levels();
+    int wanted = (threads > 0) ? threads : default_threads.load();
+    budget = (wanted > 0) ? std::min(wanted, saved_threads) : saved_threads;
+    omp_set_num_threads(budget);
+    // Teams of the kernels are flat, so a nested region (such as an Eigen
+    // product inside a parallel loop) runs on the thread that meets it
+    omp_set_max_active_levels(1);
+#ifdef EIGEN_USE_MKL_ALL
+    saved_mkl = mkl_set_num_threads_local(budget);
+#endif
+    if (default_binding != BIND_NONE && budget > 1) {
+        bind(default_binding);
+    }
+#endif
+}
+
+ThreadScope::~ThreadScope() {
+#ifdef _OPENMP
+    unbind();
+#ifdef EIGEN_USE_MKL_ALL
+    mkl_set_num_threads_local(saved_mkl);
+#endif
+    omp_set_max_active_levels(saved_levels);
+    omp_set_num_threads(saved_threads);
+#endif
+}
+
+// Pin every thread of the team of the budget to its place. OpenMP keeps the
+// threads of a team between regions, so the later regions of the call run
+// on the pinned threads
+void ThreadScope::bind(const int &binding) {
+#if defined(__linux__) && defined(_OPENMP)
+    vector<vector<int>> places = thread_places(binding, thread_affinity());
+    if (places.empty()) {
+        return;
+    }
+    saved_affinity.assign(budget, vector<int>());
+    #pragma omp parallel num_threads(budget)
+    {
+        int thread = omp_get_thread_num();
+        saved_affinity[thread] = thread_affinity();
+        set_thread_affinity(places[thread % places.size()]);
+    }
+    bound = true;
+#endif
+}
+
+void ThreadScope::unbind() {
+#if defined(__linux__) && defined(_OPENMP)
+    if (!bound) {
+        return;
+    }
+    #pragma omp parallel num_threads(budget)
+    {
+        size_t thread = omp_get_thread_num();
+        if (thread < saved_affinity.size()) {
+            set_thread_affinity(saved_affinity[thread]);
+        }
+    }
+    bound = false;
+#endif
+}
+
+//' Set and report the thread defaults of the kernels.
+//'
+//' @noRd
+//' @param threads  the default thread budget of a call, 0 for all the
+//'   threads, or negative to keep it
+//' @param binding  the pinning of the threads: none, cores or numa, or empty
+//'   to keep it
+//' @return  returns a list of the defaults, the threads OpenMP would use,
+//'   the processors, the cores and NUMA nodes threads can be pinned to, and
+//'   whether MKL is used
+// [[Rcpp::export]]
+List thread_options_(const int threads = -1, const std::string binding = "") {
+    if (!binding.empty()) {
+        auto found = std::find(std::begin(BINDINGS), std::end(BINDINGS), binding);
+        if (found == std::end(BINDINGS)) {
+            stop("Unknown binding: " + binding);
+        }
+        default_binding = int(found - std::begin(BINDINGS));
+    }
+    if (threads >= 0) {
+        default_threads = threads;
+    }
+
+    int available = 1, processors = 1, cores = 0, numa_nodes = 0;
+#ifdef _OPENMP
+    available = omp_get_max_threads();
+    processors = omp_get_num_procs();
+#endif
+#ifdef __linux__
+    vector<int> allowed = thread_affinity();
+    cores = int(thread_places(BIND_CORES, allowed).size());
+    numa_nodes = int(thread_places(BIND_NUMA, allowed).size());
+#endif
+    bool mkl = false;
+#ifdef EIGEN_USE_MKL_ALL
+    mkl = true;
+#endif
+    return(List::create(Named("threads") = default_threads.load(),
+                        Named("binding") = BINDINGS[default_binding],
+                        Named("available") = available,
+                        Named("processors") = processors,
+                        Named("cores") = cores,
+                        Named("numa_nodes") = numa_nodes,
+                        Named("mkl") = mkl));
+}
@@ -0,0 +1,52 @@
+#include "../inst/include/labyrinth.h"
+
+// Rank the k largest weights of every column without sorting the whole
+// column: std::partial_sort costs O(n log k). Ties keep their original order
+// and NaN goes last, the same as order(-x). The selected weights are scaled
+// by the mean and standard deviation of the whole column, as base::scale()
+// does, which keeps their ranking.
+//' Select the top k weights of each column.
+//'
+//' @noRd
+//' @param weights  matrix of weights, one column per query
+//' @param k  the number of top rows kept in each column
+//' @param threads  the parallel threads, 0 for the default
+//' @return  returns a list with the matrix of (1-based) row indices in
+//'   decreasing order of weight, and the matrix of their scaled weights
+// [[Rcpp::export]]
+List top_k_(const MMatrixXd &weights, const int k, int threads = 0) {
+    Index n = weights.rows(), queries = weights.cols();
+    Index top = std::max<Index>(0, std::min<Index>(k, n));
+    MatrixXi index(top, queries);
+    MatrixXd score(top, queries);
+
+    ThreadScope scope(threads);
+
+    #pragma omp parallel
+    {
+        vector<int> ranking(n);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (Index query = 0; query < queries; query++) {
+            const auto column = weights.col(query);
+            double center = column.mean();
+            double sd = std::sqrt((column.array() - center).square().sum() / (n - 1));
+
+            iota(ranking.begin(), ranking.end(), 0);
+            partial_sort(ranking.begin(), ranking.begin() + top, ranking.end(),
+                         [&column](const int &a, const int &b) {
+                             double x = column[a], y = column[b];
+                             if (std::isnan(x) || std::isnan(y) || x == y) {
+                                 return std::isnan(x) == std::isnan(y) ? a < b : std::isnan(y);
+                             }
+                             return x > y;
+                         });
+            for (Index i = 0; i < top; i++) {
+                index(i, query) = ranking[i] + 1;
+                score(i, query) = (column[ranking[i]] - center) / sd;
+            }
+        }
+    }
+
+    return(List::create(Named("index") = index, Named("score") = score));
+}